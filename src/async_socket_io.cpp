@@ -32,6 +32,16 @@ SOFTWARE.
 #include <limits>
 #include <stdarg.h>
 #include <string>
+#if defined(__linux__)
+#include <linux/errqueue.h>
+#endif
+
+#if defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY) &&                          \
+    defined(SO_EE_ORIGIN_ZEROCOPY)
+#define _HAS_ZEROCOPY_SEND 1
+#else
+#define _HAS_ZEROCOPY_SEND 0
+#endif
 
 #if _USE_ARES_LIB
 #if !defined(CARES_STATICLIB)
@@ -101,11 +111,16 @@ extern "C" {
 
 #define ASYNC_RESOLVE_TIMEOUT 45 // 45 seconds
 
+#define ZEROCOPY_LINGER_TIMEOUT 30 // 30 seconds
+#define ZEROCOPY_LINGER_POLL_INTERVAL 1000 // 1 millisecond
+
 #define MAX_WAIT_DURATION 5 * 60 * 1000 * 1000 // 5 minites
 #define MAX_PDU_BUFFER_SIZE                                                    \
   static_cast<int>(SZ(                                                         \
       1, M)) // max pdu buffer length, avoid large memory allocation when \
         // application layer decode a huge length filed.
+#define MAX_GATHER_BYTES                                                       \
+  static_cast<int>(SZ(1, M)) // max bytes of pdus gathered by one send
 
 #define TSF_CALL(stmt) this->tsf_call_([=] { (stmt); });
 
@@ -226,34 +241,96 @@ static void _set_thread_name(const char *threadName) {
 #else
 #define _set_thread_name(name)
 #endif
+
+// The event-loop running at current thread
+static thread_local event_loop *__current_loop = nullptr;
+
+// Sample the monotonic clock of event-loop
+static compatible_timepoint_t _sample_clock() {
+#if _USE_COARSE_CLOCK && !_USE_TIMERFD && defined(CLOCK_MONOTONIC_COARSE)
+  // The steady_clock of linux is CLOCK_MONOTONIC, the coarse one has same
+  // origin, costs less with a few milliseconds resolution.
+  timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+  return compatible_timepoint_t(
+      std::chrono::duration_cast<compatible_timepoint_t::duration>(
+          std::chrono::seconds(ts.tv_sec) +
+          std::chrono::nanoseconds(ts.tv_nsec)));
+#else
+  return compatible_timepoint_t::clock::now();
+#endif
+}
+
+#if _HAS_ZEROCOPY_SEND
+// Close the socket by RST, the kernel drops the bytes queued to send, so it
+// releases the pages of zerocopy sends.
+static void _abort_socket(socket_native_type fd) {
+  linger abort_close = {1, 0};
+  ::setsockopt(fd, SOL_SOCKET, SO_LINGER, (const char *)&abort_close,
+               sizeof(abort_close));
+  ::close(fd);
+}
+#endif
 } // namespace
 
 class a_pdu {
 public:
-  a_pdu(std::vector<char> &&right
+  template <typename _Bytes>
+  a_pdu(_Bytes &&right
 #if _ENABLE_SEND_CB
         ,
         send_pdu_callback_t &&callback
 #endif
         ,
         const std::chrono::microseconds &duration) {
-    data_ = std::move(right);
+    assign(std::move(right));
     offset_ = 0;
+    next_ = nullptr;
 #if _ENABLE_SEND_CB
     on_sent_ = std::move(callback);
 #endif
-    expire_time_ = std::chrono::steady_clock::now() + duration;
+    expire_time_ = async_socket_io::now() + duration;
+  }
+  // The file segment, see async_socket_io::async_sendfile
+  a_pdu(int fd, long long offset, size_t length,
+        send_pdu_callback_t &&callback,
+        const std::chrono::microseconds &duration)
+      : file_fd_(fd), file_offset_(offset), file_length_(length) {
+    offset_ = 0;
+    next_ = nullptr;
+    on_sent_ = std::move(callback);
+    expire_time_ = async_socket_io::now() + duration;
   }
-  bool expired() const {
-    return (expire_time_ - std::chrono::steady_clock::now()).count() < 0;
+  bool expired(const compatible_timepoint_t &now) const {
+    return expire_time_ < now;
   }
+  void assign(std::vector<char> &&data) { data_ = std::move(data); }
+  void assign(pdu_buffer &&data) { buffer_ = std::move(data); }
+  const char *data() const {
+    return buffer_.empty() ? data_.data() : buffer_.data();
+  }
+  size_t size() const {
+    if (file_fd_ != -1)
+      return file_length_;
+    return buffer_.empty() ? data_.size() : buffer_.size();
+  }
+  // The bytes held by pdu, counted by channel_transport::queued_bytes_
+  size_t buffered_size() const { return file_fd_ != -1 ? 0 : size(); }
   std::vector<char> data_; // sending data
+  pdu_buffer buffer_;      // sending data, slab allocated
   size_t offset_;          // offset
   send_pdu_callback_t on_sent_;
   compatible_timepoint_t expire_time_;
+  a_pdu *next_; // The next node of submit queue
+  bool zerocopy_ = false;        // whether any bytes sent by MSG_ZEROCOPY
+  unsigned int zerocopy_seq_ = 0; // The sequence of last zerocopy send
+  int file_fd_ = -1;              // The file of segment, not owned
+  long long file_offset_ = 0;     // The file offset of segment
+  size_t file_length_ = 0;        // The length of segment
+  int lane_ = SEND_LANE_NORMAL;   // The send lane
 
 #if _USE_OBJECT_POOL
-  DEFINE_OBJECT_POOL_ALLOCATION2(a_pdu, 512)
+  DEFINE_OBJECT_POOL_ALLOCATION3(a_pdu, 512)
 #endif
 };
 
@@ -262,6 +339,29 @@ channel_context::channel_context(async_socket_io &service)
   socket_.reset(new xxsocket());
 }
 
+channel_transport::~channel_transport() {
+  if (send_timer_armed_)
+    send_timer_.service_.cancel_timer(&send_timer_);
+
+  // delete the submitted pdus which not collected by event-loop
+  for (auto pdu = submit_queue_.pop_all(); pdu != nullptr;) {
+    auto next = pdu->next_;
+    delete pdu;
+    pdu = next;
+  }
+#if !_USE_SHARED_PTR
+  for (auto pdu : send_queue_)
+    delete pdu;
+  for (auto &lane : send_lanes_)
+    for (auto pdu : lane)
+      delete pdu;
+  // The zerocopy pdus are completed or the connection was reset before, see
+  // async_socket_io::perform_zerocopy_lingers & stop_service.
+  for (auto &item : zerocopy_pending_)
+    delete item.first;
+#endif
+}
+
 void channel_context::reset() {
   state_ = channel_state::INACTIVE;
 
@@ -271,22 +371,59 @@ void channel_context::reset() {
   deadline_timer_.cancel();
 }
 
-async_socket_io::async_socket_io()
-    : stopping_(false), thread_started_(false), interrupter_(),
-      connect_timeout_(5LL * MICROSECONDS_PER_SECOND),
-      send_timeout_((std::numeric_limits<int>::max)()),
-      auto_reconnect_timeout_(-1), decode_pdu_length_(nullptr) {
-  FD_ZERO(&fds_array_[read_op]);
-  FD_ZERO(&fds_array_[write_op]);
-  FD_ZERO(&fds_array_[read_op]);
+int recv_buffer_pool::size_class(int size) {
+  int cls = recv_buffer_min_size;
+  while (cls < size && cls < recv_buffer_max_size)
+    cls <<= 1;
+  return cls;
+}
 
-  maxfdp_ = 0;
+int recv_buffer_pool::class_index(int size) {
+  int index = 0;
+  for (int cls = recv_buffer_min_size; cls < size; cls <<= 1)
+    ++index;
+  return index;
+}
+
+char *recv_buffer_pool::get(int size) {
+  auto &pool = pools_[class_index(size)];
+  if (!pool) // Each chunk has 256K bytes at least.
+    pool.reset(new gc::detail::object_pool(
+        size, (std::max)(static_cast<int>(SZ(256, K)) / size, 1)));
+  return static_cast<char *>(pool->get());
+}
+
+void recv_buffer_pool::release(char *buffer, int size) {
+  pools_[class_index(size)]->release(buffer);
+}
+
+event_loop::event_loop(int index)
+    : index_(index), load_(0), interrupter_(),
+      reactor_(io_reactor::create()) {
   nfds_ = 0;
 #if _USE_ARES_LIB
   ares_ = nullptr;
   ares_count_ = 0;
 #endif
+}
+
+async_socket_io::async_socket_io()
+    : stopping_(false), thread_started_(false), thread_count_(1),
+      next_loop_(0), connect_timeout_(5LL * MICROSECONDS_PER_SECOND),
+      send_timeout_((std::numeric_limits<int>::max)()),
+      auto_reconnect_timeout_(-1), listen_backlog_(SOMAXCONN),
+      reuse_port_(true), accept_batch_size_(64), accept_rate_(0),
+      accept_burst_(64), zerocopy_threshold_(0), tcp_nodelay_(false),
+      high_watermark_(0), low_watermark_(0),
+      dispatching_pos_(0), framer_(nullptr) {
+  // The first event-loop always exists, so timers can be scheduled before
+  // service started.
+  loops_.emplace_back(new event_loop(0));
   ipsv_state_ = 0;
+
+  send_lane_weights_[SEND_LANE_URGENT] = 0;
+  send_lane_weights_[SEND_LANE_NORMAL] = 4;
+  send_lane_weights_[SEND_LANE_BULK] = 1;
 }
 
 async_socket_io::~async_socket_io() { stop_service(); }
@@ -302,20 +439,62 @@ void async_socket_io::stop_service() {
       }
     }
 
-    interrupter_.interrupt();
-    if (this->worker_thread_.joinable())
-      this->worker_thread_.join();
+    for (int i = 0; i < thread_count_; ++i)
+      loops_[i]->interrupt();
+    for (int i = 0; i < thread_count_; ++i) {
+      if (loops_[i]->thread_.joinable())
+        loops_[i]->thread_.join();
+    }
+
+#if _HAS_ZEROCOPY_SEND
+    // Reset the connections with zerocopy sends in flight before the sockets
+    // closed, so the kernel drops them before the pdus freed.
+    for (int i = 0; i < thread_count_; ++i) {
+      auto loop = loops_[i].get();
+      for (auto &linger : loop->zerocopy_lingers_)
+        _abort_socket(linger.fd);
+      loop->zerocopy_lingers_.clear();
+      for (auto &item : loop->transports_) {
+        auto &transport = item.second;
+        if (!transport->zerocopy_pending_.empty() && transport->is_open())
+          _abort_socket(transport->socket_->detach());
+      }
+    }
+#endif
 
     clear_channels();
 
-    unregister_descriptor(interrupter_.read_descriptor(), socket_event_read);
-    thread_started_ = false;
+    // wakeup the workers waiting at dispatch_transport_pdu
+    dispatch_transports_cv_.notify_all();
+
+    for (int i = 0; i < thread_count_; ++i) {
+      auto loop = loops_[i].get();
+      loop->unregister_descriptor(loop->interrupter_.read_descriptor(),
+                                  socket_event_read);
+#if _USE_TIMERFD
+      if (loop->timerfd_.is_open()) {
+        loop->unregister_descriptor(loop->timerfd_.read_descriptor(),
+                                    socket_event_read);
+        loop->timerfd_.disarm();
+      }
+#endif
+      loop->active_channels_.clear();
+      for (auto &item : loop->transports_)
+        release_recv_buffer(item.second.get());
+      loop->transports_.clear();
+      loop->ready_transports_.clear();
+      loop->writing_transports_.clear();
+      loop->accepted_sockets_.clear();
+      loop->load_ = 0;
 #if _USE_ARES_LIB
-    if (this->ares_ != nullptr) {
-      ::ares_destroy((ares_channel)this->ares_);
-      this->ares_ = nullptr;
-    }
+      if (loop->ares_ != nullptr) {
+        ::ares_destroy((ares_channel)loop->ares_);
+        loop->ares_ = nullptr;
+      }
+      loop->ares_count_ = 0;
 #endif
+    }
+    thread_started_ = false;
   }
 }
 
@@ -334,6 +513,63 @@ void async_socket_io::set_auto_reconnect_timeout(
   }
 }
 
+void async_socket_io::set_listen_backlog(int backlog) {
+  this->listen_backlog_ = backlog > 0 ? backlog : SOMAXCONN;
+}
+
+void async_socket_io::set_reuse_port(bool reuse_port) {
+  this->reuse_port_ = reuse_port;
+}
+
+void async_socket_io::set_accept_limits(int batch_size, int rate_per_sec,
+                                        int burst) {
+  this->accept_batch_size_ = batch_size > 0 ? batch_size : 1;
+  this->accept_rate_ = rate_per_sec > 0 ? rate_per_sec : 0;
+  this->accept_burst_ = burst > 0 ? burst : this->accept_batch_size_;
+}
+
+void async_socket_io::set_zerocopy_threshold(int bytes) {
+  this->zerocopy_threshold_ = bytes > 0 ? bytes : 0;
+}
+
+void async_socket_io::set_write_watermarks(size_t high_watermark,
+                                           size_t low_watermark) {
+  this->high_watermark_ = high_watermark;
+  this->low_watermark_ = (std::min)(low_watermark, high_watermark);
+}
+
+void async_socket_io::set_transport_writable_callback(
+    transport_writable_callback_t on_transport_writable) {
+  this->on_transport_writable_ = std::move(on_transport_writable);
+}
+
+void async_socket_io::set_send_lane_weight(int lane, int weight) {
+  if (lane >= 0 && lane < SEND_LANE_COUNT)
+    this->send_lane_weights_[lane] = weight > 0 ? weight : 0;
+}
+
+void async_socket_io::set_tcp_nodelay(bool nodelay) {
+  this->tcp_nodelay_ = nodelay;
+}
+
+void async_socket_io::set_framer(std::shared_ptr<pdu_framer> framer) {
+  this->framer_ = std::move(framer);
+}
+
+void async_socket_io::set_framer(size_t channel_index,
+                                 std::shared_ptr<pdu_framer> framer) {
+  if (channel_index >= channels_.size())
+    return;
+  channels_[channel_index]->framer_ = std::move(framer);
+}
+
+void async_socket_io::set_recv_buffer_size(size_t channel_index, int size) {
+  if (channel_index >= channels_.size())
+    return;
+  channels_[channel_index]->recv_buffer_size_ =
+      recv_buffer_pool::size_class(size);
+}
+
 channel_context *async_socket_io::new_channel(const channel_endpoint &ep) {
   auto ctx = new channel_context(*this);
   ctx->reset();
@@ -347,6 +583,10 @@ channel_context *async_socket_io::new_channel(const channel_endpoint &ep) {
 
 void async_socket_io::clear_channels() {
   for (auto iter = channels_.begin(); iter != channels_.end();) {
+    for (auto shard : (*iter)->shards_) {
+      shard->socket_->close();
+      delete shard;
+    }
     (*iter)->socket_->close();
     delete *(iter);
     iter = channels_.erase(iter);
@@ -359,54 +599,131 @@ void async_socket_io::set_callbacks(
     connection_lost_callback_t on_connection_lost,
     recv_pdu_callback_t on_pdu_recv,
     std::function<void(const vdcallback_t &)> threadsafe_call) {
-  this->decode_pdu_length_ = decode_length_func;
+  if (decode_length_func != nullptr)
+    this->framer_ = std::make_shared<function_framer>(decode_length_func);
   this->on_connect_resposne_ = std::move(on_connect_response);
   this->on_recv_pdu_ = std::move(on_pdu_recv);
   this->on_connection_lost_ = std::move(on_connection_lost);
   this->tsf_call_ = std::move(threadsafe_call);
 }
 
+compatible_timepoint_t async_socket_io::now() {
+  auto loop = __current_loop;
+  return loop != nullptr ? loop->now_ : _sample_clock();
+}
+
 size_t async_socket_io::get_received_pdu_count(void) const {
-  return recv_queue_.size();
+  return recv_queue_.size() + (dispatching_queue_.size() - dispatching_pos_);
 }
 
 void async_socket_io::dispatch_received_pdu(int count) {
-  assert(this->on_recv_pdu_ != nullptr);
+  assert(this->on_recv_pdu_ != nullptr || this->on_recv_pdu_batch_ != nullptr);
+
+  // Take all received pdus by swap when the last batch was dispatched, the
+  // queues exchange their capacity, so no reallocation at steady state.
+  if (dispatching_pos_ == dispatching_queue_.size()) {
+    dispatching_queue_.clear();
+    dispatching_pos_ = 0;
+    if (this->recv_queue_.empty())
+      return;
 
-  if (this->recv_queue_.empty())
-    return;
+    std::lock_guard<std::mutex> autolock(this->recv_queue_mtx_);
+    this->recv_queue_.swap(dispatching_queue_);
+  }
 
-  std::lock_guard<std::mutex> autolock(this->recv_queue_mtx_);
-  do {
-    auto packet = std::move(this->recv_queue_.front());
-    this->recv_queue_.pop_front();
-    this->on_recv_pdu_(std::move(packet));
-  } while (!this->recv_queue_.empty() && --count > 0);
+  auto n = (std::min)(dispatching_queue_.size() - dispatching_pos_,
+                      static_cast<size_t>((std::max)(count, 1)));
+  auto pdus = dispatching_queue_.data() + dispatching_pos_;
+  dispatching_pos_ += n;
+  if (this->on_recv_pdu_batch_) {
+    this->on_recv_pdu_batch_(pdus, n);
+  } else {
+    for (size_t i = 0; i < n; ++i)
+      this->on_recv_pdu_(std::move(pdus[i]));
+  }
+}
+
+void async_socket_io::set_recv_batch_callback(
+    recv_pdu_batch_callback_t on_pdu_batch_recv) {
+  this->on_recv_pdu_batch_ = std::move(on_pdu_batch_recv);
+}
+
+void async_socket_io::set_transport_recv_callback(
+    transport_recv_pdu_callback_t on_transport_pdu_recv) {
+  this->on_recv_transport_pdu_ = std::move(on_transport_pdu_recv);
+}
+
+int async_socket_io::dispatch_transport_pdu(int count, long long wait_usec) {
+  assert(this->on_recv_transport_pdu_ != nullptr);
+
+  // The pdus of a transport are taken at once, the vectors exchange their
+  // capacity, so no reallocation at steady state.
+  static thread_local std::vector<recv_pdu_type> pdus;
+  int dispatched = 0;
+  while (dispatched < count) {
+    std::shared_ptr<channel_transport> transport;
+    {
+      std::unique_lock<std::mutex> lck(this->dispatch_transports_mtx_);
+      if (this->dispatch_transports_.empty()) {
+        if (dispatched > 0 || wait_usec <= 0)
+          break;
+        this->dispatch_transports_cv_.wait_for(
+            lck, std::chrono::microseconds(wait_usec));
+        wait_usec = 0;
+        continue;
+      }
+      transport = std::move(this->dispatch_transports_.front());
+      this->dispatch_transports_.pop_front();
+    }
+
+    {
+      std::lock_guard<std::mutex> lck(transport->recv_queue_mtx_);
+      transport->recv_queue_.swap(pdus);
+    }
+
+    for (auto &pdu : pdus)
+      this->on_recv_transport_pdu_(transport, std::move(pdu));
+    dispatched += static_cast<int>(pdus.size());
+    pdus.clear();
+
+    // Requeue at tail when more pdus received while dispatching, otherwise
+    // the next pdu will schedule it again.
+    bool requeue;
+    {
+      std::lock_guard<std::mutex> lck(transport->recv_queue_mtx_);
+      requeue = !transport->recv_queue_.empty();
+      transport->dispatching_ = requeue;
+    }
+    if (requeue) {
+      std::lock_guard<std::mutex> lck(this->dispatch_transports_mtx_);
+      this->dispatch_transports_.push_back(std::move(transport));
+    }
+  }
+  return dispatched;
 }
 
 void async_socket_io::start_service(const channel_endpoint *channel_eps,
-                                    int channel_count) {
+                                    int channel_count, int thread_count) {
   if (!thread_started_) {
     if (channel_count <= 0)
       return;
+    if (thread_count <= 0)
+      thread_count = 1;
 
     stopping_ = false;
     thread_started_ = true;
+    thread_count_ = thread_count;
+
+    // Call once at startup
+    this->ipsv_state_ = xxsocket::getipsv();
+
 #if _USE_ARES_LIB
     /* Initialize the library */
     ::ares_library_init(ARES_LIB_INIT_ALL);
-
-    int ret = ::ares_init((ares_channel *)&ares_);
-
-    if (ret == ARES_SUCCESS) {
-      // set dns servers, optional, comment follow code, ares also work well.
-      // ::ares_set_servers_csv((ares_channel )ares_,
-      // "114.114.114.114,8.8.8.8");
-    } else
-      INET_LOG("Initialize ares failed: %d!", ret);
 #endif
 
-    register_descriptor(interrupter_.read_descriptor(), socket_event_read);
+    while (static_cast<int>(loops_.size()) < thread_count)
+      loops_.emplace_back(new event_loop(static_cast<int>(loops_.size())));
 
     // Initialize channels
     for (auto i = 0; i < channel_count; ++i) {
@@ -414,11 +731,33 @@ void async_socket_io::start_service(const channel_endpoint *channel_eps,
       (void)new_channel(channel_ep);
     }
 
-    worker_thread_ = std::thread([this] {
-      INET_LOG("thread running...");
-      this->service();
-      INET_LOG("thread exited.");
-    });
+    for (int i = 0; i < thread_count; ++i) {
+      auto loop = loops_[i].get();
+#if _USE_ARES_LIB
+      int ret = ::ares_init((ares_channel *)&loop->ares_);
+
+      if (ret == ARES_SUCCESS) {
+        // set dns servers, optional, comment follow code, ares also work well.
+        // ::ares_set_servers_csv((ares_channel )ares_,
+        // "114.114.114.114,8.8.8.8");
+      } else
+        INET_LOG("Initialize ares failed: %d!", ret);
+#endif
+
+      loop->register_descriptor(loop->interrupter_.read_descriptor(),
+                                socket_event_read);
+#if _USE_TIMERFD
+      if (loop->timerfd_.is_open())
+        loop->register_descriptor(loop->timerfd_.read_descriptor(),
+                                  socket_event_read);
+#endif
+
+      loop->thread_ = std::thread([this, loop] {
+        INET_LOG("thread running...");
+        this->service(loop);
+        INET_LOG("thread exited.");
+      });
+    }
   }
 }
 
@@ -446,19 +785,20 @@ void async_socket_io::set_endpoint(size_t channel_index,
   ctx->resolve_state_ = resolve_state::READY;
 }
 
-void async_socket_io::service() { // The async event-loop
+void async_socket_io::service(event_loop *loop) { // The async event-loop
   // Set Thread Name: mini async socket io
   _set_thread_name("mini-asio");
 
-  // Call once at startup
-  this->ipsv_state_ = xxsocket::getipsv();
+  INET_LOG("the event-loop %d is running with %s reactor.", loop->index_,
+           loop->reactor_->name());
 
-  // event loop
-  fd_set fds_array[3];
-  timeval timeout;
+  __current_loop = loop;
+  loop->now_ = _sample_clock();
 
+  // event loop
   for (; !stopping_;) {
-    int nfds = do_select(fds_array, timeout);
+    int nfds = do_evpoll(loop);
+    loop->now_ = _sample_clock();
 
     if (stopping_)
       break;
@@ -479,137 +819,236 @@ void async_socket_io::service() { // The async event-loop
 #endif
     }
     // Reset the interrupter.
-    else if (nfds > 0 && FD_ISSET(this->interrupter_.read_descriptor(),
-                                  &(fds_array[read_op]))) {
+    else if (nfds > 0 &&
+             loop->reactor_->is_ready(loop->interrupter_.read_descriptor(),
+                                      socket_event_read)) {
 #if _ENABLE_VERBOSE_LOG
-      bool was_interrupt = interrupter_.reset();
+      bool was_interrupt = loop->interrupter_.reset();
       INET_LOG("socket.select waked up by interrupt, interrupter fd:%d, "
                "was_interrupt:%s",
-               this->interrupter_.read_descriptor(),
+               loop->interrupter_.read_descriptor(),
                was_interrupt ? "true" : "false");
 #else
-      interrupter_.reset();
+      loop->interrupter_.reset();
 #endif
       --nfds;
     }
+#if _USE_TIMERFD
+    // The earliest timer expired, performed by perform_timeout_timers
+    if (nfds > 0 && loop->timerfd_.is_open() &&
+        loop->reactor_->is_ready(loop->timerfd_.read_descriptor(),
+                                 socket_event_read)) {
+      loop->timerfd_.reset();
+      --nfds;
+    }
+#endif
 #if _USE_ARES_LIB
     /// perform possible domain resolve requests.
-    if (this->ares_count_ > 0) {
+    if (loop->ares_count_ > 0) {
       ares_socket_t socks[ARES_GETSOCK_MAXNUM] = {0};
       int bitmask =
-          ares_getsock((ares_channel)this->ares_, socks, _ARRAYSIZE(socks));
+          ares_getsock((ares_channel)loop->ares_, socks, _ARRAYSIZE(socks));
 
       for (int i = 0; i < ARES_GETSOCK_MAXNUM; ++i) {
         if (ARES_GETSOCK_READABLE(bitmask, i) ||
             ARES_GETSOCK_WRITABLE(bitmask, i)) {
           auto fd = socks[i];
-          ::ares_process_fd(
-              (ares_channel)this->ares_,
-              FD_ISSET(fd, &(fds_array[read_op])) ? fd : ARES_SOCKET_BAD,
-              FD_ISSET(fd, &(fds_array[write_op])) ? fd : ARES_SOCKET_BAD);
+          ::ares_process_fd((ares_channel)loop->ares_,
+                            loop->reactor_->is_ready(fd, socket_event_read)
+                                ? fd
+                                : ARES_SOCKET_BAD,
+                            loop->reactor_->is_ready(fd, socket_event_write)
+                                ? fd
+                                : ARES_SOCKET_BAD);
         } else
           break;
       }
     }
 #endif
 
+    // register the sockets accepted by other event-loops
+    perform_accepted_sockets(loop);
+
     // preform transports
-    for (auto iter = transports_.begin(); iter != transports_.end();) {
-      auto &transport = *iter;
-      if (transport->offset_ > 0 ||
-          FD_ISSET(transport->socket_->native_handle(),
-                   &(fds_array[read_op]))) {
-#if _ENABLE_VERBOSE_LOG
-        INET_LOG("[index: %d] perform non-blocking read operation...",
-                 ctx->index_);
-#endif
-        if (!do_read(transport)) {
-          handle_close(transport);
-          iter = transports_.erase(iter);
-          continue;
-        }
-      }
+    perform_transports(loop);
 
-      // perform write operations
-      if (!transport->send_queue_.empty()) {
-        transport->send_queue_mtx_.lock();
-#if _ENABLE_VERBOSE_LOG
-        INET_LOG("[index: %d] perform non-blocking write operation...",
-                 ctx->index_);
-#endif
-        if (!do_write(transport)) { // TODO: check would block? for client, may
-          // be unnecessary.
-          transport->send_queue_mtx_.unlock();
-          handle_close(transport);
-          iter = transports_.erase(iter);
-          continue;
-        }
+    // poll the zerocopy completions of closed transports
+    if (!loop->zerocopy_lingers_.empty())
+      perform_zerocopy_lingers(loop);
 
-        if (!transport->send_queue_.empty())
-          ++transport->ready_events_;
+    // perform active channels
+    perform_active_channels(loop);
 
-        transport->send_queue_mtx_.unlock();
+    // perform timeout timers
+    perform_timeout_timers(loop);
+  }
+
+_L_end:
+  (void)0; // ONLY for xcode compiler happy.
+}
+
+event_loop *async_socket_io::select_loop() {
+  // Start from the next loop of last selection, so the loops with same load
+  // are used in turn.
+  unsigned int start = next_loop_++;
+  event_loop *selected = nullptr;
+  for (int i = 0; i < thread_count_; ++i) {
+    auto loop = loops_[(start + i) % thread_count_].get();
+    if (selected == nullptr || loop->load_ < selected->load_)
+      selected = loop;
+  }
+  return selected;
+}
+
+void async_socket_io::perform_active_channels(event_loop *loop) {
+  if (loop->active_channels_.empty())
+    return;
+
+  std::lock_guard<std::mutex> lk(loop->active_channels_mtx_);
+  for (auto iter = loop->active_channels_.begin();
+       iter != loop->active_channels_.end();) {
+    auto ctx = *iter;
+    bool should_remove = false;
+    switch (ctx->type_) {
+    case CHANNEL_TCP_CLIENT:
+      switch (ctx->state_) {
+      case channel_state::REQUEST_CONNECT:
+        should_remove = do_nonblocking_connect(ctx);
+        break;
+      case channel_state::CONNECTING:
+        should_remove = do_nonblocking_connect_completion(ctx);
+        break;
       }
+      break;
+    case CHANNEL_TCP_SERVER:
+
+      switch (ctx->state_) {
+      case channel_state::REQUEST_CONNECT:
+        do_nonblocking_accept(ctx);
+        break;
+      case channel_state::CONNECTING:
+        do_nonblocking_accept_completion(ctx);
+        break;
+      case channel_state::INACTIVE:
+        // closed by user, release the listening socket at event-loop thread
+        close_internal(ctx);
+        should_remove = true;
+        break;
+      }
+      break;
+    }
 
-      swap_ready_events(transport.get());
+    swap_ready_events(ctx);
 
+    if (should_remove)
+      iter = loop->active_channels_.erase(iter);
+    else
       ++iter;
-    }
+  }
+}
 
-    if (!active_channels_.empty()) {
-      // perform active channels
-      active_channels_mtx_.lock();
-      for (auto iter = active_channels_.begin();
-           iter != active_channels_.end();) {
-        auto ctx = *iter;
-        bool should_remove = false;
-        switch (ctx->type_) {
-        case CHANNEL_TCP_CLIENT:
-          switch (ctx->state_) {
-          case channel_state::REQUEST_CONNECT:
-            should_remove = do_nonblocking_connect(ctx);
-            break;
-          case channel_state::CONNECTING:
-            should_remove = do_nonblocking_connect_completion(fds_array, ctx);
-            break;
-          }
-          break;
-        case CHANNEL_TCP_SERVER:
+void async_socket_io::schedule_transport(
+    const std::shared_ptr<channel_transport> &transport) {
+  if (!transport->scheduled_) {
+    transport->scheduled_ = true;
+    transport->loop_->ready_transports_.push_back(transport);
+  }
+}
 
-          switch (ctx->state_) {
-          case channel_state::REQUEST_CONNECT:
-            do_nonblocking_accept(ctx);
-            break;
-          case channel_state::CONNECTING:
-            do_nonblocking_accept_completion(fds_array, ctx);
-            break;
-          case channel_state::INACTIVE:
-            should_remove = true;
-            break;
-          }
-          break;
-        }
+void async_socket_io::perform_transports(event_loop *loop) {
+  // collect the transports which I/O events ready, only them are dispatched,
+  // so the cost not grow with the number of idle transports.
+  for (auto &ev : loop->reactor_->ready_list()) {
+    auto iter = loop->transports_.find(ev.fd);
+    if (iter != loop->transports_.end())
+      schedule_transport(iter->second);
+  }
 
-        swap_ready_events(ctx);
+  // collect the transports which have new pdus to send, the list is pushed by
+  // write caller threads, so it can't be checked without the lock.
+  {
+    std::lock_guard<std::mutex> lk(loop->writing_transports_mtx_);
+    for (auto &transport : loop->writing_transports_)
+      schedule_transport(transport);
+    loop->writing_transports_.clear();
+  }
 
-        if (should_remove)
-          iter = active_channels_.erase(iter);
-        else
-          ++iter;
+  if (loop->ready_transports_.empty())
+    return;
+
+  loop->performing_transports_.swap(loop->ready_transports_);
+  for (auto &transport : loop->performing_transports_) {
+    transport->scheduled_ = false;
+    if (!transport->is_open()) { // closed by previous operations
+      // fail the pdus submitted while closing
+      if (transport->closed_)
+        cancel_send_pdus(transport);
+      continue;
+    }
+
+    // The stale client transport shares the reopened channel socket, it
+    // must not perform the descriptor of new connection.
+    auto fd = transport->socket_->native_handle();
+    auto iter = loop->transports_.find(fd);
+    if (iter == loop->transports_.end() || iter->second != transport)
+      continue;
+    if (transport->closing_ ||
+        loop->reactor_->is_ready(fd, socket_event_read)) {
+#if _ENABLE_VERBOSE_LOG
+      INET_LOG("[index: %d] perform non-blocking read operation...",
+               transport->channel_index());
+#endif
+      if (!do_read(transport)) {
+        loop->transports_.erase(fd);
+        handle_close(transport);
+        continue;
       }
-      active_channels_mtx_.unlock();
     }
 
-    // perform timeout timers
-    perform_timeout_timers();
-  }
+    // The completions wake up the event-loop by error event, which also
+    // reported as read event.
+    if (!transport->zerocopy_pending_.empty())
+      do_zerocopy_completion(transport, fd);
+
+    // collect the pdus submitted by write caller threads, the batch is
+    // collected after flush.
+    if (transport->batch_depth_ == 0) {
+      for (auto pdu = transport->submit_queue_.pop_all(); pdu != nullptr;) {
+        auto next = pdu->next_;
+        transport->send_lanes_[pdu->lane_].push_back(a_pdu_ptr(pdu));
+        pdu = next;
+      }
+    }
 
-_L_end:
-  (void)0; // ONLY for xcode compiler happy.
+    // perform write operations
+    if (transport->has_pending_send() &&
+        (!transport->wait_writable_ ||
+         loop->reactor_->is_ready(fd, socket_event_write))) {
+#if _ENABLE_VERBOSE_LOG
+      INET_LOG("[index: %d] perform non-blocking write operation...",
+               transport->channel_index());
+#endif
+      if (!do_write(transport)) {
+        loop->transports_.erase(fd);
+        handle_close(transport);
+        continue;
+      }
+    }
+    update_send_timer(transport);
+
+    // The remain data of recv buffer not unpacked yet, or the pdus can be sent
+    // without waiting writable event, perform it at next iteration.
+    if (transport->ready_events_ > 0 ||
+        (!transport->wait_writable_ && transport->has_pending_send())) {
+      transport->ready_events_ = 0;
+      schedule_transport(transport);
+    }
+  }
+  loop->performing_transports_.clear();
 }
 
 void async_socket_io::swap_ready_events(channel_base *ctx) {
-  this->nfds_ += ctx->ready_events_;
+  ctx->loop_->nfds_ += ctx->ready_events_;
   ctx->ready_events_ = 0;
 }
 
@@ -623,10 +1062,17 @@ void async_socket_io::close(size_t channel_index) {
     if (ctx->type_ != CHANNEL_TCP_SERVER)
       return;
     if (ctx->state_ != channel_state::INACTIVE) {
+      // The listening socket is closed by it's event-loop, see
+      // perform_active_channels
       ctx->state_ = channel_state::INACTIVE;
-      unregister_descriptor(ctx->socket_->native_handle(), socket_event_read);
-      ctx->socket_->close();
-      interrupt();
+      if (ctx->loop_ != nullptr)
+        ctx->loop_->interrupt();
+    }
+    for (auto shard : ctx->shards_) {
+      if (shard->state_ != channel_state::INACTIVE) {
+        shard->state_ = channel_state::INACTIVE;
+        shard->loop_->interrupt();
+      }
     }
   }
 
@@ -635,9 +1081,9 @@ void async_socket_io::close(size_t channel_index) {
       INET_LOG("close the transport: %s --> %s",
                transport->socket_->local_endpoint().to_string().c_str(),
                transport->socket_->peer_endpoint().to_string().c_str());
-      transport->offset_ = 1; // !IMPORTANT, trigger the close immidlately.
+      transport->closing_ = true; // !IMPORTANT, trigger the close immidlately.
       transport->socket_->shutdown();
-      interrupter_.interrupt();
+      transport->loop_->interrupt();
     }
   }
 
@@ -651,7 +1097,7 @@ void async_socket_io::close(size_t channel_index) {
 
   void async_socket_io::reopen(std::shared_ptr<channel_transport> transport) {
     if (transport->is_open()) {
-      transport->offset_ = 1; // !IMPORTANT, trigger the close immidlately.
+      transport->closing_ = true; // !IMPORTANT, trigger the close immidlately.
     }
     open_internal(transport->ctx_);
   }
@@ -675,7 +1121,13 @@ void async_socket_io::close(size_t channel_index) {
              transport->peer_endpoint().to_string().c_str(), transport->error_,
              xxsocket::get_error_msg(transport->error_));
 
+    transport->closed_ = true; // reject the writes after close
+    if (!transport->zerocopy_pending_.empty())
+      linger_zerocopy_pdus(transport);
     close_internal(transport.get());
+    release_recv_buffer(transport.get());
+    cancel_send_pdus(transport);
+    --transport->loop_->load_;
 
     auto ctx = transport->ctx_;
 
@@ -689,6 +1141,7 @@ void async_socket_io::close(size_t channel_index) {
         ctx->state_ = channel_state::INACTIVE;
       if (this->auto_reconnect_timeout_ > 0) {
         std::shared_ptr<deadline_timer> timer(new deadline_timer(*this));
+        timer->loop_ = ctx->loop_;
         timer->expires_from_now(
             std::chrono::microseconds(this->auto_reconnect_timeout_));
         timer->async_wait(
@@ -701,40 +1154,7 @@ void async_socket_io::close(size_t channel_index) {
     }
   }
 
-  void async_socket_io::register_descriptor(const socket_native_type fd,
-                                            int flags) {
-    if ((flags & socket_event_read) != 0) {
-      FD_SET(fd, &(fds_array_[read_op]));
-    }
-
-    if ((flags & socket_event_write) != 0) {
-      FD_SET(fd, &(fds_array_[write_op]));
-    }
-
-    if ((flags & socket_event_except) != 0) {
-      FD_SET(fd, &(fds_array_[except_op]));
-    }
-
-    if (maxfdp_ < static_cast<int>(fd) + 1)
-      maxfdp_ = static_cast<int>(fd) + 1;
-  }
-
-  void async_socket_io::unregister_descriptor(const socket_native_type fd,
-                                              int flags) {
-    if ((flags & socket_event_read) != 0) {
-      FD_CLR(fd, &(fds_array_[read_op]));
-    }
-
-    if ((flags & socket_event_write) != 0) {
-      FD_CLR(fd, &(fds_array_[write_op]));
-    }
-
-    if ((flags & socket_event_except) != 0) {
-      FD_CLR(fd, &(fds_array_[except_op]));
-    }
-  }
-
-  void async_socket_io::write(size_t channel_index, std::vector<char> && data
+  bool async_socket_io::write(size_t channel_index, std::vector<char> && data
 #if _ENABLE_SEND_CB
                               ,
                               send_pdu_callback_t callback
@@ -742,7 +1162,7 @@ void async_socket_io::close(size_t channel_index) {
   ) {
     // Gets channel
     if (channel_index >= channels_.size())
-      return;
+      return false;
     auto ctx = channels_[channel_index];
 
     if (ctx->state_ == channel_state::CONNECTED) {
@@ -751,34 +1171,158 @@ void async_socket_io::close(size_t channel_index) {
       INET_LOG("[index: %d] send failed, the connection not ok!",
                channel_index);
     }
+    return false;
   }
 
-  void async_socket_io::write(std::shared_ptr<channel_transport> transport,
+  bool async_socket_io::write(std::shared_ptr<channel_transport> transport,
                               std::vector<char> && data
 #if _ENABLE_SEND_CB
                               ,
                               send_pdu_callback_t callback = nullptr
 #endif
   ) {
-    if (transport->socket_->is_open()) {
-      auto pdu =
-          a_pdu_ptr(new a_pdu(std::move(data)
+    return write(transport, SEND_LANE_NORMAL, std::move(data)
 #if _ENABLE_SEND_CB
-                                  ,
-                              std::move(callback)
+                                                  ,
+                 std::move(callback)
 #endif
-                                  ,
-                              std::chrono::microseconds(this->send_timeout_)));
+    );
+  }
 
-      transport->send_queue_mtx_.lock();
-      transport->send_queue_.push_back(pdu);
-      transport->send_queue_mtx_.unlock();
+  bool async_socket_io::write(std::shared_ptr<channel_transport> transport,
+                              pdu_buffer && data
+#if _ENABLE_SEND_CB
+                              ,
+                              send_pdu_callback_t callback
+#endif
+  ) {
+    return write(transport, SEND_LANE_NORMAL, std::move(data)
+#if _ENABLE_SEND_CB
+                                                  ,
+                 std::move(callback)
+#endif
+    );
+  }
 
-      interrupter_.interrupt();
+  bool async_socket_io::write(std::shared_ptr<channel_transport> transport,
+                              int lane, std::vector<char> && data
+#if _ENABLE_SEND_CB
+                              ,
+                              send_pdu_callback_t callback
+#endif
+  ) {
+    if (transport->is_open()) {
+      auto pdu = new a_pdu(std::move(data)
+#if _ENABLE_SEND_CB
+                               ,
+                           std::move(callback)
+#endif
+                               ,
+                           std::chrono::microseconds(this->send_timeout_));
+      if (lane >= 0 && lane < SEND_LANE_COUNT)
+        pdu->lane_ = lane;
+      return write_pdu(transport, pdu);
     } else {
-      INET_LOG("[transport: %#x] send failed, the connection not ok!",
-               transport.get());
+      INET_LOG("[transport: %p] send failed, the connection not ok!",
+               static_cast<void *>(transport.get()));
     }
+    return false;
+  }
+
+  bool async_socket_io::write(std::shared_ptr<channel_transport> transport,
+                              int lane, pdu_buffer && data
+#if _ENABLE_SEND_CB
+                              ,
+                              send_pdu_callback_t callback
+#endif
+  ) {
+    if (transport->is_open()) {
+      auto pdu = new a_pdu(std::move(data)
+#if _ENABLE_SEND_CB
+                               ,
+                           std::move(callback)
+#endif
+                               ,
+                           std::chrono::microseconds(this->send_timeout_));
+      if (lane >= 0 && lane < SEND_LANE_COUNT)
+        pdu->lane_ = lane;
+      return write_pdu(transport, pdu);
+    } else {
+      INET_LOG("[transport: %p] send failed, the connection not ok!",
+               static_cast<void *>(transport.get()));
+    }
+    return false;
+  }
+
+  void async_socket_io::async_sendfile(
+      std::shared_ptr<channel_transport> transport, int fd, long long offset,
+      long long length, send_pdu_callback_t callback) {
+    if (transport->is_open() && fd != -1 && offset >= 0 &&
+        length > 0) {
+      write_pdu(transport,
+                new a_pdu(fd, offset, static_cast<size_t>(length),
+                          std::move(callback),
+                          std::chrono::microseconds(this->send_timeout_)));
+    } else {
+      INET_LOG("[transport: %p] sendfile failed, the connection not ok or "
+               "invalid file segment!",
+               static_cast<void *>(transport.get()));
+      if (callback)
+        this->tsf_call_([=] { callback(error_number::ERR_SEND_FAILED); });
+    }
+  }
+
+  void async_socket_io::begin_batch(
+      std::shared_ptr<channel_transport> transport) {
+    ++transport->batch_depth_;
+  }
+
+  void async_socket_io::flush(std::shared_ptr<channel_transport> transport) {
+    // The pdus submitted in batch didn't notify the event-loop
+    if (--transport->batch_depth_ == 0)
+      notify_writing(transport);
+  }
+
+  bool async_socket_io::write_pdu(std::shared_ptr<channel_transport> transport,
+                                  a_pdu * pdu) {
+    // Account the bytes before submit, the event-loop may send it at once.
+    auto bytes = pdu->buffered_size();
+    auto queued = transport->queued_bytes_.fetch_add(bytes);
+    if (high_watermark_ > 0 && bytes > 0 && queued > 0 &&
+        queued + bytes > high_watermark_) {
+      // Finish the rejected pdu with its callback, it gives back the bytes,
+      // and checks writable again, the queue may be drained before the flag
+      // set.
+      transport->write_blocked_ = true;
+      handle_send_finished(transport, a_pdu_ptr(pdu),
+                           error_number::ERR_SEND_WOULD_BLOCK);
+      return false;
+    }
+
+    // Only notify event-loop when the submit queue is empty before,
+    // otherwise the event-loop will collect this pdu with the previous ones.
+    // The batching transport is notified by flush.
+    if (transport->submit_queue_.push(pdu) && transport->batch_depth_ == 0)
+      notify_writing(transport);
+    return true;
+  }
+
+  void async_socket_io::notify_writing(
+      std::shared_ptr<channel_transport> transport) {
+    auto loop = transport->loop_;
+#if _SKIP_WAKEUP_IN_LOOP
+    // At the event-loop thread, such as the callbacks, schedule the
+    // transport directly, it will be performed at next iteration.
+    if (loop == __current_loop) {
+      schedule_transport(transport);
+      return;
+    }
+#endif
+    loop->writing_transports_mtx_.lock();
+    loop->writing_transports_.push_back(transport);
+    loop->writing_transports_mtx_.unlock();
+
+    loop->interrupt();
   }
 
   void async_socket_io::handle_packet(
@@ -788,14 +1332,32 @@ void async_socket_io::close(size_t channel_index) {
              "packet size:%d",
              ctx->index_, ctx->receiving_pdu_elen_);
 #endif
-    if (transport->deferred_) {
+    if (transport->deferred_ && this->on_recv_transport_pdu_) {
+      bool schedule;
+      {
+        std::lock_guard<std::mutex> lck(transport->recv_queue_mtx_);
+        transport->recv_queue_.push_back(std::move(transport->receiving_pdu_));
+        schedule = !transport->dispatching_;
+        transport->dispatching_ = true;
+      }
+      if (schedule) {
+        std::lock_guard<std::mutex> lck(this->dispatch_transports_mtx_);
+        this->dispatch_transports_.push_back(transport);
+        this->dispatch_transports_cv_.notify_one();
+      }
+    } else if (transport->deferred_) {
       recv_queue_mtx_.lock();
       // Use std::move, so no need to call
       // ctx->receiving_pdu_.shrink_to_fit to avoid occupy large
       // memory
       recv_queue_.push_back(std::move(transport->receiving_pdu_));
       recv_queue_mtx_.unlock();
-    } else
+    } else if (this->on_recv_transport_pdu_)
+      this->on_recv_transport_pdu_(transport,
+                                   std::move(transport->receiving_pdu_));
+    else if (this->on_recv_pdu_batch_)
+      this->on_recv_pdu_batch_(&transport->receiving_pdu_, 1);
+    else
       this->on_recv_pdu_(std::move(transport->receiving_pdu_));
     transport->receiving_pdu_elen_ = -1;
   }
@@ -833,8 +1395,9 @@ void async_socket_io::close(size_t channel_index) {
           return true;
         } else {
 
-          register_descriptor(ctx->socket_->native_handle(),
-                              socket_event_read | socket_event_write);
+          ctx->loop_->register_descriptor(ctx->socket_->native_handle(),
+                                          socket_event_read |
+                                              socket_event_write);
 
           ctx->deadline_timer_.expires_from_now(
               std::chrono::microseconds(this->connect_timeout_));
@@ -847,7 +1410,7 @@ void async_socket_io::close(size_t channel_index) {
           return false;
         }
       } else if (ret == 0) { // connect server succed immidiately.
-        handle_connect_succeed(ctx, ctx->socket_);
+        handle_connect_succeed(ctx->loop_, ctx, ctx->socket_);
         return true;
       }
       // NEVER GO HERE
@@ -863,17 +1426,18 @@ void async_socket_io::close(size_t channel_index) {
     return !(ctx->resolve_state_ == resolve_state::INPRROGRESS);
   }
 
-  bool async_socket_io::do_nonblocking_connect_completion(
-      fd_set * fds_array, channel_context * ctx) {
+  bool async_socket_io::do_nonblocking_connect_completion(channel_context *
+                                                         ctx) {
     if (ctx->state_ == channel_state::CONNECTING) {
       int error = -1;
-      if (FD_ISSET(ctx->socket_->native_handle(), &fds_array[write_op]) ||
-          FD_ISSET(ctx->socket_->native_handle(), &fds_array[read_op])) {
+      if (ctx->loop_->reactor_->is_ready(ctx->socket_->native_handle(),
+                                         socket_event_read |
+                                             socket_event_write)) {
         socklen_t len = sizeof(error);
         if (::getsockopt(ctx->socket_->native_handle(), SOL_SOCKET, SO_ERROR,
                          (char *)&error, &len) >= 0 &&
             error == 0) {
-          handle_connect_succeed(ctx, ctx->socket_);
+          handle_connect_succeed(ctx->loop_, ctx, ctx->socket_);
           ctx->deadline_timer_.cancel();
         } else {
           handle_connect_failed(ctx, ERR_CONNECT_FAILED);
@@ -897,6 +1461,10 @@ void async_socket_io::close(size_t channel_index) {
 
       ip::endpoint ep("0.0.0.0", ctx->port_);
       ctx->socket_->set_optval(SOL_SOCKET, SO_REUSEADDR, 1);
+#if defined(SO_REUSEPORT)
+      if (ctx->reuse_port_)
+        ctx->socket_->set_optval(SOL_SOCKET, SO_REUSEPORT, 1);
+#endif
       ctx->socket_->set_nonblocking(true);
       int error = 0;
       if (ctx->socket_->bind(ep) != 0) {
@@ -908,7 +1476,7 @@ void async_socket_io::close(size_t channel_index) {
         return;
       }
 
-      if (ctx->socket_->listen(1) != 0) {
+      if (ctx->socket_->listen(this->listen_backlog_) != 0) {
         error = xxsocket::get_last_errno();
         INET_LOG("[index: %d] listening failed, ec:%d, detail:%s", ctx->index_,
                  error, xxsocket::get_error_msg(error));
@@ -919,48 +1487,140 @@ void async_socket_io::close(size_t channel_index) {
 
       INET_LOG("[index: %d] listening at %s...", ctx->index_,
                ep.to_string().c_str());
-      register_descriptor(ctx->socket_->native_handle(), socket_event_read);
+      ctx->accept_tokens_ = this->accept_burst_;
+      ctx->accept_tokens_stamp_ =
+          std::chrono::duration_cast<std::chrono::microseconds>(
+              now().time_since_epoch())
+              .count();
+      ctx->loop_->register_descriptor(ctx->socket_->native_handle(),
+                                      socket_event_read);
     }
   }
 
-  void async_socket_io::do_nonblocking_accept_completion(
-      fd_set * fds_array, channel_context * ctx) {
+  void async_socket_io::do_nonblocking_accept_completion(channel_context *
+                                                         ctx) {
     if (ctx->state_ == channel_state::CONNECTING) {
-      int error = -1;
-      if (FD_ISSET(ctx->socket_->native_handle(), &fds_array[read_op])) {
-        socklen_t len = sizeof(error);
-        if (::getsockopt(ctx->socket_->native_handle(), SOL_SOCKET, SO_ERROR,
-                         (char *)&error, &len) >= 0 &&
-            error == 0) {
-          xxsocket client_sock = ctx->socket_->accept();
-          if (client_sock.is_open()) {
-            register_descriptor(client_sock.native_handle(), socket_event_read);
+      if (ctx->loop_->reactor_->is_ready(ctx->socket_->native_handle(),
+                                         socket_event_read)) {
+        int quota = (std::min)(this->accept_batch_size_,
+                               this->refill_accept_tokens(ctx));
+        if (quota <= 0) {
+          // Rate limited, stop watching the listening socket until a token
+          // available, so the event-loop not spin on the pending connections.
+          ctx->loop_->unregister_descriptor(ctx->socket_->native_handle(),
+                                            socket_event_read);
+          ctx->deadline_timer_.expires_from_now(std::chrono::microseconds(
+              MICROSECONDS_PER_SECOND / this->accept_rate_ + 1));
+          ctx->deadline_timer_.async_wait([this, ctx](bool cancelled) {
+            if (!cancelled && ctx->state_ == channel_state::CONNECTING &&
+                ctx->socket_->is_open())
+              ctx->loop_->register_descriptor(ctx->socket_->native_handle(),
+                                              socket_event_read);
+          });
+          return;
+        }
+
+        // Drain the backlog, at most quota connections per iteration.
+        int accepted = 0;
+        for (; accepted < quota; ++accepted) {
+          xxsocket client_sock = ctx->socket_->accept_nonblocking();
+          if (!client_sock.is_open()) {
+            int error = xxsocket::get_last_errno();
+            if (error != EWOULDBLOCK && error != EAGAIN && error != EINTR)
+              INET_LOG("[index: %d] accept failed, ec:%d, detail:%s",
+                       ctx->index_, error, xxsocket::get_error_msg(error));
+            break;
+          }
 
-            handle_connect_succeed(ctx, std::shared_ptr<xxsocket>(new xxsocket(
-                                            std::move(client_sock))));
-            ctx->state_ = channel_state::CONNECTING;
+          std::shared_ptr<xxsocket> socket(
+              new xxsocket(std::move(client_sock)));
+          // Assign the new transport to the least loaded event-loop, the
+          // sharded listeners are already load balanced by kernel.
+          auto loop = ctx->reuse_port_ ? ctx->loop_ : select_loop();
+          if (loop == ctx->loop_) {
+            loop->register_descriptor(socket->native_handle(),
+                                      socket_event_read);
+            handle_connect_succeed(loop, ctx, socket);
+          } else {
+            loop->accepted_sockets_mtx_.lock();
+            loop->accepted_sockets_.push_back(std::make_pair(ctx, socket));
+            loop->accepted_sockets_mtx_.unlock();
+            loop->interrupt();
           }
-        } else {
-          close_internal(ctx);
         }
+
+        if (this->accept_rate_ > 0)
+          ctx->accept_tokens_ -= accepted;
       }
     }
   }
 
-  void async_socket_io::handle_connect_succeed(
-      channel_context * ctx, std::shared_ptr<xxsocket> socket) {
+  int async_socket_io::refill_accept_tokens(channel_context * ctx) {
+    if (this->accept_rate_ <= 0)
+      return (std::numeric_limits<int>::max)();
+
+    auto now = std::chrono::duration_cast<std::chrono::microseconds>(
+                   async_socket_io::now().time_since_epoch())
+                   .count();
+    ctx->accept_tokens_ += static_cast<double>(now - ctx->accept_tokens_stamp_) *
+                           this->accept_rate_ / MICROSECONDS_PER_SECOND;
+    ctx->accept_tokens_stamp_ = now;
+    if (ctx->accept_tokens_ > this->accept_burst_)
+      ctx->accept_tokens_ = this->accept_burst_;
+    return static_cast<int>(ctx->accept_tokens_);
+  }
 
-    std::shared_ptr<channel_transport> transport(new channel_transport(ctx));
+  void async_socket_io::perform_accepted_sockets(event_loop * loop) {
+    if (loop->accepted_sockets_.empty())
+      return;
+
+    std::vector<std::pair<channel_context *, std::shared_ptr<xxsocket>>>
+        accepted_sockets;
+    loop->accepted_sockets_mtx_.lock();
+    accepted_sockets.swap(loop->accepted_sockets_);
+    loop->accepted_sockets_mtx_.unlock();
+
+    for (auto &item : accepted_sockets) {
+      loop->register_descriptor(item.second->native_handle(),
+                                socket_event_read);
+      handle_connect_succeed(loop, item.first, item.second);
+    }
+  }
+
+  void async_socket_io::handle_connect_succeed(
+      event_loop * loop, channel_context * ctx,
+      std::shared_ptr<xxsocket> socket) {
+
+    std::shared_ptr<channel_transport> transport(
+        new channel_transport(ctx, *this));
+    transport->loop_ = loop;
+    transport->framer_ = ctx->framer_ ? ctx->framer_.get() : framer_.get();
+#if _HAS_ZEROCOPY_SEND
+    if (this->zerocopy_threshold_ > 0)
+      transport->zerocopy_ = socket->set_optval(SOL_SOCKET, SO_ZEROCOPY, 1) == 0;
+#endif
+    if (this->tcp_nodelay_)
+      socket->set_optval(IPPROTO_TCP, TCP_NODELAY, 1);
 
     if (ctx->type_ == CHANNEL_TCP_CLIENT) { // The client channl
-      unregister_descriptor(socket->native_handle(),
-                            socket_event_write); // remove write event avoid
+      loop->unregister_descriptor(
+          socket->native_handle(),
+          socket_event_write); // remove write event avoid
       // high-CPU occupation
       ctx->state_ = channel_state::CONNECTED;
     }
 
     transport->socket_ = socket;
-    this->transports_.push_back(transport);
+    // Replace the stale transport which socket was closed without close
+    // notification, i.e. the client channel reconnecting.
+    auto &slot = loop->transports_[socket->native_handle()];
+    if (!slot)
+      ++loop->load_;
+    else {
+      slot->closed_ = true;
+      cancel_send_pdus(slot);
+    }
+    slot = transport;
 
     auto connection = transport->socket_;
     INET_LOG("[index: %d] the connection [%s] ---> %s is established.",
@@ -988,43 +1648,136 @@ void async_socket_io::close(size_t channel_index) {
     auto ctx = transport->ctx_;
     do {
       int n;
+      bool would_block = false;
 
       if (!transport->socket_->is_open())
         break;
 
+      pick_send_pdus(transport.get());
       if (!transport->send_queue_.empty()) {
-        auto v = transport->send_queue_.front();
-        auto outstanding_bytes = static_cast<int>(v->data_.size() - v->offset_);
-        n = transport->socket_->send_i(v->data_.data() + v->offset_,
-                                       outstanding_bytes);
-        if (n == outstanding_bytes) { // All pdu bytes sent.
+        // Gather the queued pdus, send them with one syscall.
+        socket_buffer_type bufs[IOV_MAX];
+        int count = 0;
+        int outstanding_bytes = 0;
+        int flags = 0;
+        a_pdu_ptr file_pdu = nullptr;
+        for (auto &v : transport->send_queue_) {
+          if (count >= IOV_MAX || outstanding_bytes >= MAX_GATHER_BYTES)
+            break;
+          // The file segment is sent alone by sendfile after the pdus before
+          // it, at most MAX_GATHER_BYTES each time.
+          if (v->file_fd_ != -1) {
+            if (count == 0) {
+              file_pdu = v;
+              outstanding_bytes = static_cast<int>((std::min)(
+                  v->size() - v->offset_,
+                  static_cast<size_t>(MAX_GATHER_BYTES)));
+            }
+            break;
+          }
+#if _HAS_ZEROCOPY_SEND
+          // The large pdu is sent alone by MSG_ZEROCOPY
+          if (transport->zerocopy_ &&
+              v->size() >= static_cast<size_t>(zerocopy_threshold_)) {
+            if (count > 0)
+              break;
+            flags = MSG_ZEROCOPY;
+          }
+#endif
+          auto bytes = static_cast<int>(v->size() - v->offset_);
+          xxsocket::set_buffer(bufs[count++], v->data() + v->offset_,
+                               bytes);
+          outstanding_bytes += bytes;
+          if (flags != 0)
+            break;
+        }
+
+        // More pdus follow the gathered ones, tell the kernel don't push the
+        // partial segment, the last send of queue pushes all.
+        int more_flags = 0;
+#if defined(MSG_MORE)
+        if (count < static_cast<int>(transport->send_queue_.size()) ||
+            transport->has_lane_pdus())
+          more_flags = MSG_MORE;
+#endif
+
+        if (file_pdu != nullptr) {
+          n = transport->socket_->sendfile_i(
+              file_pdu->file_fd_,
+              file_pdu->file_offset_ + static_cast<long long>(file_pdu->offset_),
+              outstanding_bytes);
+        } else
+          n = transport->socket_->sendv_i(bufs, count, flags | more_flags);
+#if _HAS_ZEROCOPY_SEND
+        if (flags != 0) {
+          if (n >= 0) { // The pdu must be alive until the completion
+            auto v = transport->send_queue_.front();
+            v->zerocopy_ = true;
+            v->zerocopy_seq_ = transport->zerocopy_seq_++;
+          } else if (xxsocket::get_last_errno() == ENOBUFS) // optmem limit
+            n = transport->socket_->sendv_i(bufs, count, more_flags);
+        }
+#endif
+        if (file_pdu != nullptr && n == 0) {
+          // The file is shorter than the segment, the connection is ok.
+          INET_LOG("[index: %d] do_write sendfile failed, the file segment "
+                   "out of range, %dbytes still outstanding!",
+                   ctx->index_,
+                   static_cast<int>(file_pdu->size() - file_pdu->offset_));
           transport->send_queue_.pop_front();
-#if _ENABLE_VERBOSE_LOG
-          auto packet_size = static_cast<int>(v->data_.size());
-          INET_LOG("[index: %d] do_write ok, A packet sent "
-                   "success, packet size:%d",
-                   ctx->index_, packet_size);
-#endif
-          handle_send_finished(v, error_number::ERR_OK);
-        } else if (n > 0) {    // TODO: add time
-          if (!v->expired()) { // change offset, remain data will
-            // send next time.
-            // v->data_.erase(v->data_.begin(), v->data_.begin() +
-            // n);
-            v->offset_ += n;
-            outstanding_bytes = static_cast<int>(v->data_.size() - v->offset_);
-            INET_LOG("[index: %d] do_write pending, %dbytes still "
-                     "outstanding, "
-                     "%dbytes was sent!",
-                     ctx->index_, outstanding_bytes, n);
-          } else { // send timeout
+          handle_send_finished(transport, file_pdu,
+                               error_number::ERR_SEND_FAILED);
+        } else if (n > 0) {
+          // pop the pdus which all bytes sent
+          int bytes_sent = n;
+          while (bytes_sent > 0) {
+            auto v = transport->send_queue_.front();
+            auto bytes = static_cast<int>(v->size() - v->offset_);
+            if (bytes_sent < bytes)
+              break;
+            bytes_sent -= bytes;
             transport->send_queue_.pop_front();
-
-            auto packet_size = static_cast<int>(v->data_.size());
-            INET_LOG("[index: %d] do_write packet timeout, packet "
-                     "size:%d",
+#if _ENABLE_VERBOSE_LOG
+            auto packet_size = static_cast<int>(v->size());
+            INET_LOG("[index: %d] do_write ok, A packet sent "
+                     "success, packet size:%d",
                      ctx->index_, packet_size);
-            handle_send_finished(v, error_number::ERR_SEND_TIMEOUT);
+#endif
+            if (v->zerocopy_)
+              transport->zerocopy_pending_.push_back(
+                  std::make_pair(v, error_number::ERR_OK));
+            else
+              handle_send_finished(transport, v, error_number::ERR_OK);
+          }
+
+          // The file segment may be sent by several times without blocking
+          if (bytes_sent > 0 || n < outstanding_bytes) { // TODO: add time
+            auto v = transport->send_queue_.front();
+            // change offset, remain data will send next time.
+            if (!v->expired(transport->loop_->now_)) {
+              v->offset_ += bytes_sent;
+              if (n < outstanding_bytes) {
+                would_block = true;
+                outstanding_bytes -= n;
+                INET_LOG("[index: %d] do_write pending, %dbytes still "
+                         "outstanding, "
+                         "%dbytes was sent!",
+                         ctx->index_, outstanding_bytes, n);
+              }
+            } else { // send timeout
+              transport->send_queue_.pop_front();
+
+              auto packet_size = static_cast<int>(v->size());
+              INET_LOG("[index: %d] do_write packet timeout, packet "
+                       "size:%d",
+                       ctx->index_, packet_size);
+              if (v->zerocopy_)
+                transport->zerocopy_pending_.push_back(
+                    std::make_pair(v, error_number::ERR_SEND_TIMEOUT));
+              else
+                handle_send_finished(transport, v,
+                                     error_number::ERR_SEND_TIMEOUT);
+            }
           }
         } else { // n <= 0, TODO: add time
           int error = transport->refresh_socket_error();
@@ -1035,18 +1788,262 @@ void async_socket_io::close(size_t channel_index) {
                      ctx->index_, n, error, xxsocket::get_error_msg(error));
             break;
           }
+          would_block = true;
         }
       }
 
+      unpick_send_pdus(transport.get());
+
+      // Wait writable event when the socket send buffer is full, stop waiting
+      // after all pdus sent, avoid busy event-loop.
+      if (would_block) {
+        if (!transport->wait_writable_) {
+          transport->loop_->register_descriptor(
+              transport->socket_->native_handle(), socket_event_write);
+          transport->wait_writable_ = true;
+        }
+      } else if (transport->wait_writable_ &&
+                 !transport->has_pending_send()) {
+        transport->loop_->unregister_descriptor(
+            transport->socket_->native_handle(), socket_event_write);
+        transport->wait_writable_ = false;
+      }
+
       bRet = true;
     } while (false);
 
     return bRet;
   }
 
-  void async_socket_io::handle_send_finished(a_pdu_ptr pdu,
-                                             error_number error) {
-#if _ENABLE_SEND_CB
+  void async_socket_io::update_send_timer(
+      std::shared_ptr<channel_transport> transport) {
+    if (transport->wait_writable_ && transport->has_lane_pdus()) {
+      if (transport->send_timer_armed_)
+        return;
+
+      // The pdus of a lane expire in order
+      auto earliest = (compatible_timepoint_t::max)();
+      for (auto &lane : transport->send_lanes_)
+        if (!lane.empty() && lane.front()->expire_time_ < earliest)
+          earliest = lane.front()->expire_time_;
+
+      auto &timer = transport->send_timer_;
+      timer.loop_ = transport->loop_;
+      timer.expire_time_ = earliest;
+      transport->send_timer_armed_ = true;
+      std::weak_ptr<channel_transport> weak_transport = transport;
+      timer.async_wait([this, weak_transport](bool cancelled) {
+        auto transport = weak_transport.lock();
+        if (!cancelled && transport && transport->is_open())
+          this->handle_send_timeout(transport);
+      });
+    } else if (transport->send_timer_armed_) {
+      transport->send_timer_armed_ = false;
+      cancel_timer(&transport->send_timer_);
+    }
+  }
+
+  void async_socket_io::cancel_send_pdus(
+      std::shared_ptr<channel_transport> transport) {
+    // No writable callback for the closed transport.
+    transport->write_blocked_ = false;
+    if (transport->send_timer_armed_) {
+      transport->send_timer_armed_ = false;
+      cancel_timer(&transport->send_timer_);
+    }
+
+    for (auto v : transport->send_queue_)
+      handle_send_finished(transport, v, error_number::ERR_CONNECTION_LOST);
+    transport->send_queue_.clear();
+    for (auto &lane : transport->send_lanes_) {
+      for (auto v : lane)
+        handle_send_finished(transport, v, error_number::ERR_CONNECTION_LOST);
+      lane.clear();
+    }
+    for (auto pdu = transport->submit_queue_.pop_all(); pdu != nullptr;) {
+      auto next = pdu->next_;
+      handle_send_finished(transport, a_pdu_ptr(pdu),
+                           error_number::ERR_CONNECTION_LOST);
+      pdu = next;
+    }
+  }
+
+  void async_socket_io::handle_send_timeout(
+      std::shared_ptr<channel_transport> transport) {
+    transport->send_timer_armed_ = false;
+
+    // The partially sent pdu is handled by do_write, it can't be dropped
+    // before the bytes of it sent.
+    auto &now = transport->loop_->now_;
+    for (auto &lane : transport->send_lanes_) {
+      while (!lane.empty() && lane.front()->expired(now)) {
+        auto v = lane.front();
+        lane.pop_front();
+        INET_LOG("[index: %d] the queued packet timeout, packet size:%d",
+                 transport->channel_index(), static_cast<int>(v->size()));
+        handle_send_finished(transport, v, error_number::ERR_SEND_TIMEOUT);
+      }
+    }
+
+    update_send_timer(transport);
+  }
+
+  void async_socket_io::pick_send_pdus(channel_transport * transport) {
+    auto &queue = transport->send_queue_;
+    size_t bytes = 0;
+    for (auto v : queue)
+      bytes += v->size() - v->offset_;
+    while (static_cast<int>(queue.size()) < IOV_MAX &&
+           bytes < static_cast<size_t>(MAX_GATHER_BYTES)) {
+      int lane = pick_send_lane(transport);
+      if (lane < 0)
+        break;
+      auto v = transport->send_lanes_[lane].front();
+      transport->send_lanes_[lane].pop_front();
+      queue.push_back(v);
+      bytes += v->size();
+    }
+  }
+
+  void async_socket_io::unpick_send_pdus(channel_transport * transport) {
+    // The pdus not started yet can be overtaken by the higher priority ones
+    // written later, the partially sent one must be finished first.
+    auto &queue = transport->send_queue_;
+    while (!queue.empty() && queue.back()->offset_ == 0 &&
+           !queue.back()->zerocopy_) {
+      auto v = queue.back();
+      queue.pop_back();
+      transport->send_lanes_[v->lane_].push_front(v);
+    }
+  }
+
+  int async_socket_io::pick_send_lane(channel_transport * transport) {
+    for (int lane = 0; lane < SEND_LANE_COUNT; ++lane)
+      if (send_lane_weights_[lane] == 0 &&
+          !transport->send_lanes_[lane].empty())
+        return lane;
+
+    // weighted round robin, every lane is visited once at most with full
+    // credit.
+    for (int i = 0; i <= SEND_LANE_COUNT; ++i) {
+      int lane = transport->wrr_lane_;
+      if (transport->wrr_credit_ > 0 && !transport->send_lanes_[lane].empty()) {
+        --transport->wrr_credit_;
+        return lane;
+      }
+      transport->wrr_lane_ = (lane + 1) % SEND_LANE_COUNT;
+      transport->wrr_credit_ = send_lane_weights_[transport->wrr_lane_];
+    }
+    return -1;
+  }
+
+  void async_socket_io::do_zerocopy_completion(
+      std::shared_ptr<channel_transport> transport, socket_native_type fd) {
+#if _HAS_ZEROCOPY_SEND
+    char control[128];
+    msghdr msg;
+    for (;;) {
+      ::memset(&msg, 0, sizeof(msg));
+      msg.msg_control = control;
+      msg.msg_controllen = sizeof(control);
+      if (::recvmsg(fd, &msg, MSG_ERRQUEUE) == -1)
+        break; // EAGAIN: no more notifications
+
+      for (auto cm = CMSG_FIRSTHDR(&msg); cm != nullptr;
+           cm = CMSG_NXTHDR(&msg, cm)) {
+        if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+              (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+          continue;
+        auto serr = reinterpret_cast<sock_extended_err *>(CMSG_DATA(cm));
+        if (serr->ee_errno != 0 || serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+          continue;
+
+        // The sends [ee_info, ee_data] completed, TCP completes them in order
+        auto &pending = transport->zerocopy_pending_;
+        while (!pending.empty() &&
+               static_cast<int>(pending.front().first->zerocopy_seq_ -
+                                serr->ee_data) <= 0) {
+          auto item = pending.front();
+          pending.pop_front();
+          handle_send_finished(transport, item.first, item.second);
+        }
+      }
+    }
+#else
+    (void)transport;
+    (void)fd;
+#endif
+  }
+
+  void async_socket_io::linger_zerocopy_pdus(
+      std::shared_ptr<channel_transport> transport) {
+#if _HAS_ZEROCOPY_SEND
+    auto loop = transport->loop_;
+    auto fd = transport->socket_->native_handle();
+    do_zerocopy_completion(transport, fd);
+    if (transport->zerocopy_pending_.empty())
+      return;
+
+    // Take the descriptor from socket, so the transport is closed, and the
+    // channel socket of client can be reopened.
+    loop->unregister_descriptor(fd, socket_event_read | socket_event_write);
+    transport->socket_->detach();
+    ::shutdown(fd, SHUT_WR); // FIN after the queued bytes
+
+    zerocopy_linger linger;
+    linger.transport = transport;
+    linger.fd = fd;
+    linger.expire_time =
+        loop->now_ + std::chrono::seconds(ZEROCOPY_LINGER_TIMEOUT);
+    loop->zerocopy_lingers_.push_back(std::move(linger));
+#else
+    (void)transport;
+#endif
+  }
+
+  void async_socket_io::perform_zerocopy_lingers(event_loop * loop) {
+#if _HAS_ZEROCOPY_SEND
+    auto &lingers = loop->zerocopy_lingers_;
+    for (auto iter = lingers.begin(); iter != lingers.end();) {
+      auto transport = iter->transport;
+      auto &pending = transport->zerocopy_pending_;
+      do_zerocopy_completion(transport, iter->fd);
+      if (!pending.empty() && loop->now_ < iter->expire_time) {
+        ++iter;
+        continue;
+      }
+
+      if (pending.empty()) {
+        // Discard the unread bytes, the close with them resets connection.
+        char discard[512];
+        while (::recv(iter->fd, discard, sizeof(discard), MSG_DONTWAIT) > 0)
+          ;
+        ::close(iter->fd);
+      } else {
+        INET_LOG("[index: %d] the zerocopy sends aren't completed in %d "
+                 "seconds, reset the connection, pending pdus:%d",
+                 transport->channel_index(), ZEROCOPY_LINGER_TIMEOUT,
+                 static_cast<int>(pending.size()));
+        _abort_socket(iter->fd);
+        for (auto &item : pending)
+          handle_send_finished(transport, item.first,
+                               error_number::ERR_CONNECTION_LOST);
+        pending.clear();
+      }
+      iter = lingers.erase(iter);
+    }
+#else
+    (void)loop;
+#endif
+  }
+
+  void async_socket_io::handle_send_finished(
+      std::shared_ptr<channel_transport> transport, a_pdu_ptr pdu,
+      error_number error) {
+    transport->queued_bytes_ -= pdu->buffered_size();
+    check_writable(transport);
+
+    // The file segments always have callback regardless of _ENABLE_SEND_CB
     if (pdu->on_sent_) {
       auto send_cb = std::move(pdu->on_sent_);
       this->tsf_call_([=] { send_cb(error); });
@@ -1054,12 +2051,14 @@ void async_socket_io::close(size_t channel_index) {
 #if !_USE_SHARED_PTR
     delete pdu;
 #endif
-#else
-    (void)error;
-#if !_USE_SHARED_PTR
-    delete pdu;
-#endif
-#endif
+  }
+
+  void async_socket_io::check_writable(
+      std::shared_ptr<channel_transport> transport) {
+    if (transport->write_blocked_ &&
+        transport->queued_bytes_ <= low_watermark_ &&
+        transport->write_blocked_.exchange(false) && on_transport_writable_)
+      this->tsf_call_([=] { on_transport_writable_(transport); });
   }
 
   bool async_socket_io::do_read(std::shared_ptr<channel_transport> transport) {
@@ -1069,52 +2068,57 @@ void async_socket_io::close(size_t channel_index) {
       if (!transport->socket_->is_open())
         break;
 
+      // Take a recv buffer from pool, it's given back when all the received
+      // bytes were unpacked.
+      if (transport->buffer_ == nullptr) {
+        transport->buffer_size_ = ctx->recv_buffer_size_;
+        transport->buffer_ =
+            transport->loop_->recv_buffers_.get(transport->buffer_size_);
+      }
+
+      // Reclaim the consumed space of recv buffer, the unpacked bytes are
+      // always consumed, only an incomplete pdu header may remain. The last
+      // byte is reserved for the legacy decode func which may terminate
+      // the data with '\0'.
+      int capacity = transport->buffer_size_ - 1;
+      if (transport->wpos_ == capacity) {
+        transport->wpos_ -= transport->rpos_;
+        ::memmove(transport->buffer_, transport->buffer_ + transport->rpos_,
+                  transport->wpos_);
+        transport->rpos_ = 0;
+      }
+
       int n = transport->socket_->recv_i(
-          transport->buffer_ + transport->offset_,
-          socket_recv_buffer_size - transport->offset_);
+          transport->buffer_ + transport->wpos_,
+          capacity - transport->wpos_);
 
       if (n > 0 || !SHOULD_CLOSE_0(n, transport->refresh_socket_error())) {
 #if _ENABLE_VERBOSE_LOG
         INET_LOG("[index: %d] do_read status ok, ec:%d, detail:%s", ctx->index_,
-                 error_, xxsocket::get_error_msg(error_));
+                 transport->error_,
+                 xxsocket::get_error_msg(transport->error_));
 #endif
         if (n == -1)
           n = 0;
+        transport->wpos_ += n;
 #if _ENABLE_VERBOSE_LOG
         if (n > 0) {
           INET_LOG("[index: %d] do_read ok, received data len: %d, "
                    "buffer data "
                    "len: %d",
-                   ctx->index_, n, n + ctx->offset_);
+                   ctx->index_, n, transport->wpos_ - transport->rpos_);
         }
 #endif
-        if (transport->receiving_pdu_elen_ == -1) { // decode length
-          if (decode_pdu_length_(transport->buffer_, transport->offset_ + n,
-                                 transport->receiving_pdu_elen_)) {
-            if (transport->receiving_pdu_elen_ > 0) { // ok
-              transport->receiving_pdu_.reserve(
-                  (std::min)(transport->receiving_pdu_elen_,
-                             MAX_PDU_BUFFER_SIZE)); // #perfomance, avoid
-              // memory reallocte.
-              do_unpack(transport, transport->receiving_pdu_elen_, n);
-            } else { // header insufficient, wait readfd ready at
-              // next event step.
-              transport->offset_ += n;
-            }
-          } else {
-            // set_errorno(ctx, error_number::ERR_DPL_ILLEGAL_PDU);
-            INET_LOG("[index: %d] do_read error, decode length of "
-                     "pdu failed, "
-                     "the connection should be closed!",
-                     ctx->index_);
-            break;
-          }
-        } else { // process incompleted pdu
-          do_unpack(transport,
-                    transport->receiving_pdu_elen_ -
-                        static_cast<int>(transport->receiving_pdu_.size()),
-                    n);
+        if (!do_unpack(transport)) {
+          // set_errorno(ctx, error_number::ERR_DPL_ILLEGAL_PDU);
+          INET_LOG("[index: %d] do_read error, decode length of "
+                   "pdu failed, "
+                   "the connection should be closed!",
+                   ctx->index_);
+          break;
         }
+        if (transport->rpos_ == transport->wpos_) // idle, give back buffer
+          release_recv_buffer(transport.get());
       } else {
         int error = transport->error_;
         const char *errormsg = xxsocket::get_error_msg(error);
@@ -1137,31 +2141,63 @@ void async_socket_io::close(size_t channel_index) {
     return bRet;
   }
 
-  void async_socket_io::do_unpack(std::shared_ptr<channel_transport> ctx,
-                                  int bytes_expected, int bytes_transferred) {
-    auto bytes_available = bytes_transferred + ctx->offset_;
-    ctx->receiving_pdu_.insert(ctx->receiving_pdu_.end(), ctx->buffer_,
-                               ctx->buffer_ +
-                                   (std::min)(bytes_expected, bytes_available));
+  bool async_socket_io::do_unpack(std::shared_ptr<channel_transport> ctx) {
+    // Unpack all pdus of recv buffer at once, the whole pdu in buffer is
+    // copied to it's own vector directly, the incomplete one is appended to
+    // receiving_pdu_, so the buffer never hold the pdu body.
+    while (ctx->rpos_ < ctx->wpos_) {
+      auto data = ctx->buffer_ + ctx->rpos_;
+      int bytes_available = ctx->wpos_ - ctx->rpos_;
+      if (ctx->receiving_pdu_elen_ == -1) { // decode length
+        int len = ctx->framer_->decode_length(data, bytes_available,
+                                              ctx->framer_scanned_);
+        if (len < 0)
+          return false;
 
-    ctx->offset_ = bytes_available -
-                   bytes_expected; // set offset to bytes of remain buffer
-    if (ctx->offset_ >= 0) {       // pdu received properly
-      if (ctx->offset_ >
-          0) // move remain data to head of buffer and hold offset.
-      {
-        ::memmove(ctx->buffer_, ctx->buffer_ + bytes_expected, ctx->offset_);
-        // not all data consumed, so add events for this context
-        ++ctx->ready_events_;
+        if (len == 0) { // header insufficient, wait readfd ready at next event
+                        // step, the framer can't decode the full buffer.
+          if (ctx->rpos_ == 0 && ctx->wpos_ == ctx->buffer_size_ - 1)
+            return false;
+          break;
+        }
+
+        ctx->framer_scanned_ = 0;
+        ctx->receiving_pdu_elen_ = len;
+
+        if (bytes_available >= ctx->receiving_pdu_elen_) {
+          ctx->receiving_pdu_.assign(data, data + ctx->receiving_pdu_elen_);
+          ctx->rpos_ += ctx->receiving_pdu_elen_;
+          // move properly pdu to ready queue, GL thread will retrieve
+          // it.
+          handle_packet(ctx);
+          continue;
+        }
+
+        ctx->receiving_pdu_.reserve((std::min)(
+            ctx->receiving_pdu_elen_,
+            MAX_PDU_BUFFER_SIZE)); // #perfomance, avoid memory reallocte.
       }
-      // move properly pdu to ready queue, GL thread will retrieve
-      // it.
-      handle_packet(ctx);
-      ctx->receiving_pdu_elen_ = -1;
-    } else { // all buffer consumed, set offset to ZERO, pdu
-      // incomplete, continue recv remain data.
-      ctx->offset_ = 0;
+
+      // process incompleted pdu
+      int bytes_expected = ctx->receiving_pdu_elen_ -
+                           static_cast<int>(ctx->receiving_pdu_.size());
+      int bytes = (std::min)(bytes_expected, bytes_available);
+      ctx->receiving_pdu_.insert(ctx->receiving_pdu_.end(), data,
+                                 data + bytes);
+      ctx->rpos_ += bytes;
+      if (bytes == bytes_expected) // pdu received properly
+        handle_packet(ctx);
+    }
+    return true;
+  }
+
+  void async_socket_io::release_recv_buffer(channel_transport * transport) {
+    if (transport->buffer_ != nullptr) {
+      transport->loop_->recv_buffers_.release(transport->buffer_,
+                                              transport->buffer_size_);
+      transport->buffer_ = nullptr;
     }
+    transport->rpos_ = transport->wpos_ = 0;
   }
 
   void async_socket_io::schedule_timer(deadline_timer * timer) {
@@ -1171,31 +2207,38 @@ void async_socket_io::close(size_t channel_index) {
     if (timer == nullptr)
       return;
 
-    std::lock_guard<std::recursive_mutex> lk(this->timer_queue_mtx_);
-    if (std::find(timer_queue_.begin(), timer_queue_.end(), timer) !=
-        timer_queue_.end())
-      return;
-
-    this->timer_queue_.push_back(timer);
+    // The timer without owner event-loop is scheduled to the first one.
+    if (timer->loop_ == nullptr)
+      timer->loop_ = loops_[0].get();
+    auto loop = timer->loop_;
 
-    std::sort(this->timer_queue_.begin(), this->timer_queue_.end(),
-              [](deadline_timer *lhs, deadline_timer *rhs) {
-                return lhs->wait_duration() > rhs->wait_duration();
-              });
+    std::lock_guard<std::recursive_mutex> lk(loop->timer_queue_mtx_);
+    if (!loop->timer_queue_.push(timer))
+      return;
 
-    if (timer == *this->timer_queue_.begin())
-      interrupter_.interrupt();
+    // The earliest timer changed, wake up event-loop to adjust wait duration.
+    if (timer == loop->timer_queue_.top()) {
+#if _SKIP_WAKEUP_IN_LOOP
+      if (loop == __current_loop) // will adjust at next iteration
+        return;
+#endif
+      loop->interrupt();
+    }
   }
 
-  void async_socket_io::cancel_timer(deadline_timer * timer) {
-    std::lock_guard<std::recursive_mutex> lk(this->timer_queue_mtx_);
+  bool async_socket_io::cancel_timer(deadline_timer * timer) {
+    auto loop = timer->loop_;
+    if (loop == nullptr)
+      return false;
 
-    auto iter = std::find(timer_queue_.begin(), timer_queue_.end(), timer);
-    if (iter != timer_queue_.end()) {
+    std::lock_guard<std::recursive_mutex> lk(loop->timer_queue_mtx_);
+
+    if (loop->timer_queue_.erase(timer)) {
       auto callback = timer->callback_;
       callback(true);
-      timer_queue_.erase(iter);
+      return true;
     }
+    return false;
   }
 
   void async_socket_io::open_internal(channel_context * ctx) {
@@ -1209,29 +2252,66 @@ void async_socket_io::close(size_t channel_index) {
     if (ctx->resolve_state_ != resolve_state::READY)
       update_resolve_state(ctx);
 
+    // The channel is bound to an event-loop at first open, all of it's
+    // connections & timers are performed by that event-loop.
+    if (ctx->loop_ == nullptr) {
+      ctx->loop_ = select_loop();
+      ctx->deadline_timer_.loop_ = ctx->loop_;
+    }
+
+#if defined(SO_REUSEPORT)
+    // Shard the server channel, one listener per event-loop, so the accepts
+    // don't contend on a single listening socket.
+    if (ctx->type_ == CHANNEL_TCP_SERVER && thread_count_ > 1 &&
+        this->reuse_port_ && !ctx->reuse_port_) {
+      ctx->reuse_port_ = true;
+      for (int i = 0; i < thread_count_; ++i) {
+        auto loop = loops_[i].get();
+        if (loop == ctx->loop_)
+          continue;
+        auto shard = new channel_context(*this);
+        shard->reset();
+        shard->type_ = ctx->type_;
+        shard->address_ = ctx->address_;
+        shard->port_ = ctx->port_;
+        shard->index_ = ctx->index_;
+        shard->recv_buffer_size_ = ctx->recv_buffer_size_;
+        shard->framer_ = ctx->framer_;
+        shard->reuse_port_ = true;
+        shard->loop_ = loop;
+        shard->deadline_timer_.loop_ = loop;
+        ctx->shards_.push_back(shard);
+      }
+    }
+    for (auto shard : ctx->shards_)
+      open_internal(shard);
+#endif
+
     ctx->state_ = channel_state::REQUEST_CONNECT;
     if (ctx->socket_->is_open()) {
       ctx->socket_->shutdown();
     }
 
-    active_channels_mtx_.lock();
-    this->active_channels_.push_back(ctx);
-    active_channels_mtx_.unlock();
+    auto loop = ctx->loop_;
+    loop->active_channels_mtx_.lock();
+    loop->active_channels_.push_back(ctx);
+    loop->active_channels_mtx_.unlock();
 
-    interrupter_.interrupt();
+    loop->interrupt();
   }
 
-  void async_socket_io::perform_timeout_timers() {
-    if (this->timer_queue_.empty())
+  void async_socket_io::perform_timeout_timers(event_loop * loop) {
+    auto &timer_queue = loop->timer_queue_;
+    if (timer_queue.empty())
       return;
 
-    std::lock_guard<std::recursive_mutex> lk(this->timer_queue_mtx_);
+    std::lock_guard<std::recursive_mutex> lk(loop->timer_queue_mtx_);
 
     std::vector<deadline_timer *> loop_timers;
-    while (!this->timer_queue_.empty()) {
-      auto earliest = timer_queue_.back();
-      if (earliest->expired()) {
-        timer_queue_.pop_back();
+    while (!timer_queue.empty()) {
+      auto earliest = timer_queue.top();
+      if (!(loop->now_ < earliest->expire_time_)) {
+        timer_queue.pop();
         auto callback = earliest->callback_;
         callback(false);
         if (earliest->repeated_) {
@@ -1243,70 +2323,103 @@ void async_socket_io::close(size_t channel_index) {
       }
     }
 
-    if (!loop_timers.empty()) {
-      this->timer_queue_.insert(this->timer_queue_.end(), loop_timers.begin(),
-                                loop_timers.end());
-      std::sort(this->timer_queue_.begin(), this->timer_queue_.end(),
-                [](deadline_timer *lhs, deadline_timer *rhs) {
-                  return lhs->wait_duration() > rhs->wait_duration();
-                });
-    }
+    for (auto timer : loop_timers)
+      timer_queue.push(timer);
   }
 
-  int async_socket_io::do_select(fd_set * fds_array, timeval & maxtv) {
+  int async_socket_io::do_evpoll(event_loop * loop) {
     /*
-  @Optimize, swap nfds, make sure do_read & do_write event chould
-  be perform when no need to call socket.select However, the
-  connection exception will detected through do_read or do_write,
-  but it's ok.
+  @Optimize, swap nfds, when the channels or transports have outstanding
+  works, just poll I/O events without waiting, make sure do_read & do_write
+  could be perform immediately.
   */
-    int nfds = this->flush_ready_events();
-    ::memcpy(fds_array, this->fds_array_, sizeof(this->fds_array_));
-    if (nfds <= 0) {
-      auto wait_duration = get_wait_duration(MAX_WAIT_DURATION);
-      if (wait_duration > 0) {
+    long long wait_duration = 0;
+    if (this->flush_ready_events(loop) <= 0 &&
+        loop->ready_transports_.empty()) {
+      wait_duration = get_wait_duration(loop, MAX_WAIT_DURATION);
+      if (wait_duration < 0)
+        wait_duration = 0;
+#if _USE_TIMERFD
+      // The timerfd wakes up the reactor at the earliest timer precisely, so
+      // the reactor waits without timeout.
+      if (wait_duration > 0 && loop->timerfd_.is_open()) {
+        std::lock_guard<std::recursive_mutex> lk(loop->timer_queue_mtx_);
+        if (!loop->timer_queue_.empty()) {
+          loop->timerfd_.arm(loop->timer_queue_.top()->expire_time_);
+          wait_duration = MAX_WAIT_DURATION;
+        } else
+          loop->timerfd_.disarm();
+      }
+#endif
+      // The lingering zerocopy sockets are not in reactor, poll them.
+      if (!loop->zerocopy_lingers_.empty() &&
+          wait_duration > ZEROCOPY_LINGER_POLL_INTERVAL)
+        wait_duration = ZEROCOPY_LINGER_POLL_INTERVAL;
+    }
+
+#if _USE_ARES_LIB
+    // The ares sockets are opened & closed by ares internally, so only keep
+    // them in reactor during waiting.
+    ares_socket_t socks[ARES_GETSOCK_MAXNUM] = {0};
+    int ares_nfds = 0;
+    if (loop->ares_count_ > 0) {
+      int bitmask =
+          ::ares_getsock((ares_channel)loop->ares_, socks, _ARRAYSIZE(socks));
+      for (; ares_nfds < ARES_GETSOCK_MAXNUM; ++ares_nfds) {
+        int events = 0;
+        if (ARES_GETSOCK_READABLE(bitmask, ares_nfds))
+          events |= socket_event_read;
+        if (ARES_GETSOCK_WRITABLE(bitmask, ares_nfds))
+          events |= socket_event_write;
+        if (events == 0)
+          break;
+        loop->register_descriptor(socks[ares_nfds], events);
+      }
+
+      if (ares_nfds > 0 && wait_duration > 0) {
+        timeval maxtv, tv = {0};
         maxtv.tv_sec = static_cast<long>(wait_duration / 1000000);
         maxtv.tv_usec = static_cast<long>(wait_duration % 1000000);
-#if _ENABLE_VERBOSE_LOG
-        INET_LOG("socket.select maxfdp:%d waiting... %ld milliseconds", maxfdp_,
-                 maxtv.tv_sec * 1000 + maxtv.tv_usec / 1000);
+        auto pmaxtv = ::ares_timeout((ares_channel)loop->ares_, &maxtv, &tv);
+        wait_duration = pmaxtv->tv_sec * 1000000LL + pmaxtv->tv_usec;
+      }
+    }
 #endif
-#if !_USE_ARES_LIB
-        nfds = ::select(this->maxfdp_, &(fds_array[read_op]),
-                        &(fds_array[write_op]), nullptr, &maxtv);
-#else
-        timeval *pmaxtv = &maxtv;
-        if (this->ares_count_ > 0 &&
-            ::ares_fds((ares_channel)this->ares_, &fds_array[read_op],
-                       &fds_array[write_op]) > 0) {
-          struct timeval tv = {0};
-          pmaxtv = ::ares_timeout((ares_channel)this->ares_, &maxtv, &tv);
-        }
-        nfds = ::select(this->maxfdp_, &(fds_array[read_op]),
-                        &(fds_array[write_op]), nullptr, pmaxtv);
+
+#if _ENABLE_VERBOSE_LOG
+    INET_LOG("socket.%s waiting... %lld milliseconds", loop->reactor_->name(),
+             wait_duration / 1000);
 #endif
 
+    int nfds = loop->reactor_->run_once(wait_duration);
+
 #if _ENABLE_VERBOSE_LOG
-        INET_LOG("socket.select waked up, retval=%d", nfds);
+    INET_LOG("socket.%s waked up, retval=%d", loop->reactor_->name(), nfds);
+#endif
+
+#if _USE_ARES_LIB
+    for (int i = 0; i < ares_nfds; ++i)
+      loop->unregister_descriptor(socks[i],
+                                  socket_event_read | socket_event_write);
 #endif
-      } else {
-        nfds = static_cast<int>(channels_.size()) << 1;
-      }
-    }
 
     return nfds;
   }
 
-  long long async_socket_io::get_wait_duration(long long usec) {
-    if (this->timer_queue_.empty()) {
+  long long async_socket_io::get_wait_duration(event_loop * loop,
+                                               long long usec) {
+    if (loop->timer_queue_.empty()) {
       return usec;
     }
 
-    std::lock_guard<std::recursive_mutex> autolock(this->timer_queue_mtx_);
-    deadline_timer *earliest = timer_queue_.back();
+    std::lock_guard<std::recursive_mutex> autolock(loop->timer_queue_mtx_);
+    deadline_timer *earliest = loop->timer_queue_.top();
 
-    // microseconds
-    auto duration = earliest->wait_duration();
+    // Sample the clock again before waiting, the works of this iteration may
+    // take time, the loop is idle, so it's not a hot path.
+    loop->now_ = _sample_clock();
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(
+        earliest->expire_time_ - loop->now_);
     if (std::chrono::microseconds(usec) > duration)
       return duration.count();
     else
@@ -1315,8 +2428,9 @@ void async_socket_io::close(size_t channel_index) {
 
   bool async_socket_io::close_internal(channel_base * ctx) {
     if (ctx->socket_->is_open()) {
-      unregister_descriptor(ctx->socket_->native_handle(),
-                            socket_event_read | socket_event_write);
+      ctx->loop_->unregister_descriptor(ctx->socket_->native_handle(),
+                                        socket_event_read |
+                                            socket_event_write);
       ctx->socket_->close();
       return true;
     }
@@ -1336,9 +2450,9 @@ void async_socket_io::close(size_t channel_index) {
       ctx->resolve_state_ = resolve_state::FAILED;
   }
 
-  int async_socket_io::flush_ready_events() {
-    int nfds = this->nfds_;
-    this->nfds_ = 0;
+  int async_socket_io::flush_ready_events(event_loop * loop) {
+    int nfds = loop->nfds_;
+    loop->nfds_ = 0;
     return nfds;
   }
 
@@ -1364,7 +2478,7 @@ void async_socket_io::close(size_t channel_index) {
 #else
       noblocking = true;
       hint.ai_family = AF_INET;
-      ::ares_getaddrinfo((ares_channel)this->ares_, ctx->address_.c_str(),
+      ::ares_getaddrinfo((ares_channel)ctx->loop_->ares_, ctx->address_.c_str(),
                          nullptr, &hint, ares_getaddrinfo_callback, ctx);
 #endif
     } else if (this->ipsv_state_ &
@@ -1399,14 +2513,14 @@ void async_socket_io::close(size_t channel_index) {
           std::chrono::seconds(ASYNC_RESOLVE_TIMEOUT));
       ctx->deadline_timer_.async_wait([=](bool cancelled) {
         if (!cancelled) {
-          ::ares_cancel((ares_channel)this
+          ::ares_cancel((ares_channel)ctx->loop_
                             ->ares_); // It's seems not trigger socket close,
           // because ares_getaddrinfo has bug yet.
           handle_connect_failed(ctx, ERR_RESOLVE_HOST_TIMEOUT);
         }
       });
 
-      ++this->ares_count_;
+      ++ctx->loop_->ares_count_;
     }
 
     return false;
@@ -1414,14 +2528,19 @@ void async_socket_io::close(size_t channel_index) {
   }
 
   void async_socket_io::finish_async_resolve(
-      channel_context *) { // Only call at event-loop thread, so no
-                           // need to consider thread safe.
+      channel_context *ctx) { // Only call at event-loop thread, so no
+                              // need to consider thread safe.
 #if _USE_ARES_LIB
-    --this->ares_count_;
+    --ctx->loop_->ares_count_;
+#else
+    (void)ctx;
 #endif
   }
 
-  void async_socket_io::interrupt() { interrupter_.interrupt(); }
+  void async_socket_io::interrupt() {
+    for (auto &loop : loops_)
+      loop->interrupt();
+  }
 
   /*int async_socket_io::set_errorno(channel_context* ctx, int
   error)
@@ -30,7 +30,11 @@ SOFTWARE.
 #define _ASYNC_SOCKET_IO_H_
 #include "deadline_timer.h"
 #include "endian_portable.h"
+#include "io_reactor.hpp"
+#include "mpsc_queue.h"
 #include "object_pool.h"
+#include "pdu_buffer.h"
+#include "pdu_framer.h"
 #include "select_interrupter.hpp"
 #include "singleton.h"
 #include "xxsocket.h"
@@ -42,12 +46,31 @@ SOFTWARE.
 #include <mutex>
 #include <queue>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #define _USE_ARES_LIB 1
-#define _USE_SHARED_PTR 1
+#define _USE_SHARED_PTR 0
 #define _USE_OBJECT_POOL 1
 #define _ENABLE_SEND_CB 0
+#define _SKIP_WAKEUP_IN_LOOP 1 // write at event-loop thread without wakeup
+#define _USE_PDU_BUFFER 0 // received pdus are pdu_buffer, not std::vector<char>
+
+// The event-loop clock is CLOCK_MONOTONIC_COARSE(linux), a few milliseconds
+// resolution, it's ignored when _USE_TIMERFD enabled.
+#if !defined(_USE_COARSE_CLOCK)
+#define _USE_COARSE_CLOCK 0
+#endif
+
+// The event-loop waits the earliest timer by timerfd(linux) for
+// sub-millisecond precision, instead of the reactor wait timeout.
+#if !defined(_USE_TIMERFD) || !defined(__linux__)
+#undef _USE_TIMERFD
+#define _USE_TIMERFD 0
+#endif
+#if _USE_TIMERFD
+#include "timerfd_timer.hpp"
+#endif
 
 #if !defined(_ARRAYSIZE)
 #define _ARRAYSIZE(A) (sizeof(A) / sizeof((A)[0]))
@@ -75,6 +98,15 @@ enum class resolve_state {
   FAILED = -1,
 };
 
+// The send lanes of transport, the lower lane has higher priority, a lane
+// always sends its pdus in order.
+enum send_lane {
+  SEND_LANE_URGENT, // i.e. heartbeat, input ack
+  SEND_LANE_NORMAL, // the lane of write without lane
+  SEND_LANE_BULK,   // i.e. snapshot
+  SEND_LANE_COUNT,
+};
+
 enum error_number {
   ERR_OK,                         // NO ERROR
   ERR_CONNECT_FAILED = -201,      // connect failed
@@ -90,17 +122,18 @@ enum error_number {
   ERR_RESOLVE_HOST_IPV6_REQUIRED, // resolve host ip failed, a valid ipv6 host
   // required.
   ERR_INVALID_PORT, // invalid port.
-};
-
-enum {
-  socket_event_read = 1,
-  socket_event_write = 2,
-  socket_event_except = 4,
+  ERR_SEND_WOULD_BLOCK, // send rejected, the queued bytes exceed the high
+                        // watermark.
 };
 
 typedef std::function<void()> vdcallback_t;
 
-static const int socket_recv_buffer_size = 65536; // 64K
+static const int socket_recv_buffer_size = 65536; // 64K, the default
+
+// The size classes of recv buffer pool: 4K, 8K, ... 1M
+static const int recv_buffer_min_size = 4096;
+static const int recv_buffer_max_size = 1048576;
+static const int recv_buffer_size_classes = 9;
 
 class a_pdu; // application layer protocol data unit.
 
@@ -111,7 +144,17 @@ typedef a_pdu *a_pdu_ptr;
 #endif
 
 typedef std::function<void(error_number)> send_pdu_callback_t;
-typedef std::function<void(std::vector<char>)> recv_pdu_callback_t;
+// The received pdu, the pdu_buffer avoids heap allocation.
+#if _USE_PDU_BUFFER
+typedef pdu_buffer recv_pdu_type;
+#else
+typedef std::vector<char> recv_pdu_type;
+#endif
+
+typedef std::function<void(recv_pdu_type)> recv_pdu_callback_t;
+// The batch of received pdus, the pdus can be moved by callee.
+typedef std::function<void(recv_pdu_type *pdus, size_t count)>
+    recv_pdu_batch_callback_t;
 
 class async_socket_io;
 struct channel_endpoint {
@@ -120,12 +163,114 @@ struct channel_endpoint {
 };
 
 struct channel_transport;
+struct channel_context;
+
+// The size-classed recv buffer pool of event-loop, the transport only holds a
+// buffer while receiving, not thread safe, must be called at event-loop thread.
+class recv_buffer_pool {
+public:
+  // Round up the size to it's size class.
+  static int size_class(int size);
+
+  char *get(int size);
+  void release(char *buffer, int size);
+
+private:
+  static int class_index(int size);
+
+  std::unique_ptr<gc::detail::object_pool> pools_[recv_buffer_size_classes];
+};
+
+// The closed transport whose MSG_ZEROCOPY sends are still in flight, the
+// kernel keeps transmitting from the pages of pdus after close, so the pdus and
+// the descriptor are kept until the completions.
+struct zerocopy_linger {
+  std::shared_ptr<channel_transport> transport;
+  socket_native_type fd;
+  compatible_timepoint_t expire_time;
+};
+
+// The event-loop of async socket service, each event-loop runs at it's own
+// thread with it's own reactor, interrupter and timer queue.
+struct event_loop {
+  event_loop(int index);
+
+  int index_;
+  std::thread thread_;
+
+  // The number of transports owned by this event-loop, for load balance.
+  std::atomic<int> load_;
+
+  // select interrupter
+  select_interrupter interrupter_;
+
+  // The I/O event demultiplexer: epoll or select
+  std::unique_ptr<io_reactor> reactor_;
+
+  std::mutex active_channels_mtx_;
+  std::vector<channel_context *> active_channels_;
+
+  // All established transports, key is the socket descriptor
+  std::unordered_map<socket_native_type, std::shared_ptr<channel_transport>>
+      transports_;
+
+  // The transports should be performed at current iteration, I/O events ready
+  // or has outstanding works, such as remain data of recv buffer.
+  std::vector<std::shared_ptr<channel_transport>> ready_transports_;
+  std::vector<std::shared_ptr<channel_transport>> performing_transports_;
+
+  // The transports have new pdus to send, written by write caller threads
+  std::mutex writing_transports_mtx_;
+  std::vector<std::shared_ptr<channel_transport>> writing_transports_;
+
+  // The sockets accepted by other event-loops and assigned to this one
+  std::mutex accepted_sockets_mtx_;
+  std::vector<std::pair<channel_context *, std::shared_ptr<xxsocket>>>
+      accepted_sockets_;
+
+  // The recv buffers of transports
+  recv_buffer_pool recv_buffers_;
+
+  // The closed transports waiting the zerocopy completions, not in reactor
+  std::vector<zerocopy_linger> zerocopy_lingers_;
+
+  // timer support
+  deadline_timer_queue timer_queue_;
+  std::recursive_mutex timer_queue_mtx_;
+
+  // The time of current iteration, updated after I/O events polled, see
+  // async_socket_io::now
+  compatible_timepoint_t now_;
+
+#if _USE_TIMERFD
+  // The timer descriptor armed at the earliest timer
+  timerfd_timer timerfd_;
+#endif
+
+  // Optimize record incomplete works
+  int nfds_;
+
+#if _USE_ARES_LIB
+  // non blocking io dns resolve support
+  void *ares_; //
+  int ares_count_;
+#endif
+
+  void register_descriptor(const socket_native_type fd, int flags) {
+    reactor_->register_descriptor(fd, flags);
+  }
+  void unregister_descriptor(const socket_native_type fd, int flags) {
+    reactor_->unregister_descriptor(fd, flags);
+  }
+  void interrupt() { interrupter_.interrupt(); }
+};
 
 struct channel_base {
   std::shared_ptr<xxsocket> socket_;
   channel_state
       state_; // 0: INACTIVE, 1: REQUEST_CONNECT, 2: CONNECTING, 3: CONNECTED
   int ready_events_ = 0;
+  event_loop *loop_ = nullptr; // The owner event-loop
 };
 
 struct channel_context : public channel_base {
@@ -141,9 +286,24 @@ struct channel_context : public channel_base {
 
   int index_ = -1;
 
+  // The recv buffer size of the transports of this channel
+  int recv_buffer_size_ = socket_recv_buffer_size;
+
+  // The framer of the transports of this channel, nullptr: use the service one
+  std::shared_ptr<pdu_framer> framer_;
+
   // The deadline timer for resolve & connect
   deadline_timer deadline_timer_;
 
+  // The server channel listens at every event-loop with SO_REUSEPORT, the
+  // kernel load balances the incoming connections between the listeners.
+  bool reuse_port_ = false;
+  std::vector<channel_context *> shards_; // The listeners at other loops
+
+  // The token bucket of accept rate limit, server channel only
+  double accept_tokens_ = 0;
+  long long accept_tokens_stamp_ = 0;
+
   void reset();
 };
 
@@ -151,30 +311,91 @@ struct channel_transport : public channel_base {
   friend class async_socket_io;
 
 public:
-  bool is_open() const { return socket_ != nullptr && socket_->is_open(); }
+  ~channel_transport();
+  bool is_open() const {
+    return !closed_ && socket_ != nullptr && socket_->is_open();
+  }
   ip::endpoint local_endpoint() const { return socket_->local_endpoint(); }
   ip::endpoint peer_endpoint() const { return socket_->peer_endpoint(); }
   int channel_index() const { return ctx_->index_; }
   int error_code() const { return error_; }
   void set_deferred(bool deferred) { deferred_ = deferred_; }
+  // The bytes of the pdus queued to send, file segments are not counted
+  size_t queued_bytes() const { return queued_bytes_; }
 
 private:
-  channel_transport(channel_context *ctx) : ctx_(ctx) {
+  channel_transport(channel_context *ctx, async_socket_io &service)
+      : ctx_(ctx), batch_depth_(0), queued_bytes_(0), write_blocked_(false),
+        send_timer_(service), closed_(false) {
     state_ = (channel_state::CONNECTED);
   }
   channel_context *ctx_;
 
-  char buffer_[socket_recv_buffer_size + 1]; // recv buffer
-  int offset_ = 0;                           // recv buffer offset
+  char *buffer_ = nullptr; // recv buffer, taken from pool while receiving
+  int buffer_size_ = 0;    // recv buffer capacity
+  int rpos_ = 0;           // recv buffer read position
+  int wpos_ = 0;           // recv buffer write position
+
+  pdu_framer *framer_ = nullptr; // hold by channel or service
+  int framer_scanned_ = 0;       // the bytes examined by framer
 
-  std::vector<char> receiving_pdu_;
+  recv_pdu_type receiving_pdu_;
   int receiving_pdu_elen_ = -1;
   int error_ = 0; // socket error(>= -1), application error(< -1)
 
-  std::recursive_mutex send_queue_mtx_;
+  // The pdus submitted by write caller threads, lock-free
+  mpsc_queue<a_pdu> submit_queue_;
+  // The pdus to send by lane, only accessed by event-loop thread
+  std::deque<a_pdu_ptr> send_lanes_[SEND_LANE_COUNT];
+  int wrr_lane_ = 0;   // The lane of weighted round robin
+  int wrr_credit_ = 0; // The pdus can be sent by wrr_lane_
+  // The pdus picked from lanes to send, only the partially sent pdu is kept
+  // after do_write, others are given back to lanes.
   std::deque<a_pdu_ptr> send_queue_;
 
+  bool has_lane_pdus() const {
+    for (auto &lane : send_lanes_)
+      if (!lane.empty())
+        return true;
+    return false;
+  }
+  bool has_pending_send() const {
+    return !send_queue_.empty() || has_lane_pdus();
+  }
+
+  // MSG_ZEROCOPY support, the pdus sent are kept until the kernel notify the
+  // completion by socket error queue.
+  bool zerocopy_ = false;
+  unsigned int zerocopy_seq_ = 0; // The sequence of next zerocopy send
+  std::deque<std::pair<a_pdu_ptr, error_number>> zerocopy_pending_;
+
+  // The nesting depth of begin_batch, the submitted pdus are held while > 0
+  std::atomic<int> batch_depth_;
+
+  // The write backpressure, the write rejected by high watermark sets the
+  // blocked flag, the writable callback is invoked when the queued bytes
+  // falls to low watermark.
+  std::atomic<size_t> queued_bytes_;
+  std::atomic<bool> write_blocked_;
+
+  // The timer of the earliest send deadline of lanes, it's armed only while
+  // waiting writable, otherwise the pdus are sent before deadline.
+  deadline_timer send_timer_;
+  bool send_timer_armed_ = false;
+
   bool deferred_ = true; // whether use queue
+  bool closing_ = false; // closed by user, perform read to trigger the close
+  // The connection is lost, the client transports share the channel socket,
+  // so the stale one isn't open even the socket reopened.
+  std::atomic<bool> closed_;
+
+  bool scheduled_ = false;     // whether in the ready list of event-loop
+
+  // The received pdus of per transport dispatch mode
+  std::mutex recv_queue_mtx_;
+  std::vector<recv_pdu_type> recv_queue_;
+  bool dispatching_ = false; // whether queued or being dispatched by worker
+  bool wait_writable_ = false; // whether waiting the socket writable event
 
   int refresh_socket_error() {
     error_ = xxsocket::get_last_errno();
@@ -192,6 +413,11 @@ public:
   // connection callbacks
   typedef std::function<void(std::shared_ptr<channel_transport>)>
       connection_lost_callback_t;
+  typedef std::function<void(std::shared_ptr<channel_transport>)>
+      transport_writable_callback_t;
+  typedef std::function<void(std::shared_ptr<channel_transport>,
+                             recv_pdu_type &&)>
+      transport_recv_pdu_callback_t;
   typedef std::function<void(size_t, std::shared_ptr<channel_transport>,
                              int ec)>
       connect_response_callback_t;
@@ -200,9 +426,10 @@ public:
   async_socket_io();
   ~async_socket_io();
 
-  // start async socket service
+  // start async socket service, with thread_count event-loops, the new
+  // transports are assigned to the least loaded event-loop.
   void start_service(const channel_endpoint *channel_eps,
-                     int channel_count = 1);
+                     int channel_count = 1, int thread_count = 1);
 
   void stop_service();
 
@@ -212,9 +439,15 @@ public:
 
   size_t get_received_pdu_count(void) const;
 
-  // must be call on main thread(such cocos2d-x opengl thread)
+  // must be call on main thread(such cocos2d-x opengl thread), all the
+  // received pdus are taken by one lock, and dispatched outside the lock.
   void dispatch_received_pdu(int count = 512);
 
+  // The time of current iteration at the event-loop thread, i.e. the
+  // callbacks of timers, it's sampled once per iteration. The clock time at
+  // other threads.
+  static compatible_timepoint_t now();
+
   // set callbacks, required API, must call by user
   /*
 threadsafe_call: for cocos2d-x should be:
@@ -228,12 +461,85 @@ threadsafe_call: for cocos2d-x should be:
                      recv_pdu_callback_t on_pdu_recv,
                      std::function<void(const vdcallback_t &)> threadsafe_call);
 
+  // set the framer of all channels, it replaces the decode_length_func of
+  // set_callbacks, i.e. fixed_header_framer, varint_framer, delimiter_framer
+  // or user defined framer.
+  void set_framer(std::shared_ptr<pdu_framer> framer);
+
+  // set the framer of the channel, the channel uses the framer of service when
+  // it's nullptr.
+  void set_framer(size_t channel_index, std::shared_ptr<pdu_framer> framer);
+
+  // set the batch callback, the dispatch_received_pdu calls it with the
+  // taken pdus at once, instead of the on_pdu_recv of set_callbacks.
+  void set_recv_batch_callback(recv_pdu_batch_callback_t on_pdu_batch_recv);
+
+  // set the callback of per transport dispatch mode, the received pdus are
+  // queued by transport, and dispatched with the transport by
+  // dispatch_transport_pdu, instead of the on_pdu_recv of set_callbacks.
+  void set_transport_recv_callback(
+      transport_recv_pdu_callback_t on_transport_pdu_recv);
+
+  // Dispatch the pdus of ready transports, can be called by many worker
+  // threads, a transport is dispatched by one worker at a time, so the pdus
+  // of a transport are always in order. Waits wait_usec for a ready transport
+  // if none, returns the number of dispatched pdus.
+  int dispatch_transport_pdu(int count = 512, long long wait_usec = 0);
+
+  // set the min size of pdu sent by MSG_ZEROCOPY(linux 4.14+), 0: disable,
+  // the pdus are sent alone, not gathered with others. It's only worth for
+  // the large pdus, i.e. >= 64K.
+  void set_zerocopy_threshold(int bytes);
+
+  // set the weight of send lane, the lanes of weight 0 are strict priority,
+  // they're always sent first. The others share the rest by weighted round
+  // robin of pdus. The large pdu is sent in chunks, but once started, it's
+  // finished before others, the pdus of stream can't be interleaved. Default:
+  // URGENT: 0, NORMAL: 4, BULK: 1.
+  void set_send_lane_weight(int lane, int weight);
+
+  // set TCP_NODELAY of the transports connected later, default: false. The
+  // small pdus are sent immediately, use begin_batch/flush to coalesce them.
+  void set_tcp_nodelay(bool nodelay);
+
+  // set the write watermarks of transports, 0: unlimited(default). The write
+  // returns false without queuing the pdu when the queued bytes would exceed
+  // the high watermark, its send callback gets ERR_SEND_WOULD_BLOCK. The
+  // writable callback is invoked when the queued bytes falls to low
+  // watermark, then the producer can continue writing. The pdu is always
+  // queued when the queue is empty. The batch held by begin_batch is counted,
+  // it never drains before flush.
+  void set_write_watermarks(size_t high_watermark, size_t low_watermark);
+
+  // set the callback invoked at the thread of tsf_call when the write blocked
+  // transport becomes writable.
+  void set_transport_writable_callback(
+      transport_writable_callback_t on_transport_writable);
+
   // set connect and send timeouts.
   void set_timeouts(long connect_timeout_secs, long send_timeout_secs);
 
   void set_auto_reconnect_timeout(
       long timeout_secs = -1 /*-1: disable auto connect */);
 
+  // set the backlog of server channel listening socket, default: SOMAXCONN
+  void set_listen_backlog(int backlog);
+
+  // set whether the server channels opened later listen at every event-loop
+  // by SO_REUSEPORT, default: true. false: one listener hands off the
+  // accepted connections to the least loaded event-loop.
+  void set_reuse_port(bool reuse_port);
+
+  // set the max connections accepted by each listener per event-loop
+  // iteration(default: 64), and the accept rate limit of each listener by
+  // token bucket, rate_per_sec: 0: unlimited, burst: 0: same as batch_size.
+  void set_accept_limits(int batch_size, int rate_per_sec = 0, int burst = 0);
+
+  // set the recv buffer size of the channel transports(default: 64K), it's
+  // rounded up to power of 2, between 4K and 1M. The buffer is only held while
+  // receiving, the idle transports don't hold any.
+  void set_recv_buffer_size(size_t channel_index, int size);
+
   // open a channel, default: TCP_CLIENT
   void open(size_t channel_index, int channel_type = CHANNEL_TCP_CLIENT);
 
@@ -248,14 +554,18 @@ threadsafe_call: for cocos2d-x should be:
   // Whether the client-->server connection established.
   bool is_connected(size_t cahnnel_index = 0) const;
 
-  void write(size_t channel_index, std::vector<char> &&data
+  // The writes return true when the pdu is queued. They return false when the
+  // transport isn't open, or the high watermark rejects the pdu, then the
+  // send callback is invoked with ERR_SEND_WOULD_BLOCK and the producer should
+  // wait the writable callback, see set_write_watermarks.
+  bool write(size_t channel_index, std::vector<char> &&data
 #if _ENABLE_SEND_CB
              ,
              send_pdu_callback_t callback = nullptr
 #endif
   );
 
-  void write(std::shared_ptr<channel_transport> transport,
+  bool write(std::shared_ptr<channel_transport> transport,
              std::vector<char> &&data
 #if _ENABLE_SEND_CB
              ,
@@ -263,10 +573,50 @@ threadsafe_call: for cocos2d-x should be:
 #endif
   );
 
-  // timer support
+  // write the slab allocated pdu, i.e. obinarystream::take_pdu_buffer
+  bool write(std::shared_ptr<channel_transport> transport, pdu_buffer &&data
+#if _ENABLE_SEND_CB
+             ,
+             send_pdu_callback_t callback = nullptr
+#endif
+  );
+
+  // write the pdu to the send lane, see send_lane
+  bool write(std::shared_ptr<channel_transport> transport, int lane,
+             std::vector<char> &&data
+#if _ENABLE_SEND_CB
+             ,
+             send_pdu_callback_t callback = nullptr
+#endif
+  );
+  bool write(std::shared_ptr<channel_transport> transport, int lane,
+             pdu_buffer &&data
+#if _ENABLE_SEND_CB
+             ,
+             send_pdu_callback_t callback = nullptr
+#endif
+  );
+
+  // the pdus written between begin_batch and flush are held until flush,
+  // then sent with as few syscalls and TCP segments as possible. The batches
+  // can be nested, the outermost flush sends them. It's per transport, the
+  // pdus written by other threads at the same time are held too.
+  void begin_batch(std::shared_ptr<channel_transport> transport);
+  void flush(std::shared_ptr<channel_transport> transport);
+
+  // send the file segment [offset, offset + length) without user space copy,
+  // it's queued with the pdus written by this transport and sent in order.
+  // The fd is not owned, it must be kept open until the callback invoked at
+  // the thread of tsf_call.
+  void async_sendfile(std::shared_ptr<channel_transport> transport, int fd,
+                      long long offset, long long length,
+                      send_pdu_callback_t callback = nullptr);
+
+  // timer support, cancel_timer returns false when the timer isn't in queue
   void schedule_timer(deadline_timer *);
-  void cancel_timer(deadline_timer *);
+  bool cancel_timer(deadline_timer *);
 
+  // interrupt all event-loops
   void interrupt();
 
   // Async resolve handlers, It's only for internal use
@@ -276,28 +626,63 @@ threadsafe_call: for cocos2d-x should be:
 private:
   void open_internal(channel_context *);
 
-  void perform_timeout_timers(); // ALL timer expired
+  // Gets the least loaded event-loop, round-robin when the loads are equal.
+  event_loop *select_loop();
+
+  void perform_timeout_timers(event_loop *); // ALL timer expired
 
-  long long get_wait_duration(long long usec);
+  long long get_wait_duration(event_loop *, long long usec);
 
-  int do_select(fd_set *fds_array, timeval &timeout);
+  int do_evpoll(event_loop *);
 
   bool do_nonblocking_connect(channel_context *);
-  bool do_nonblocking_connect_completion(fd_set *fds_array, channel_context *);
+  bool do_nonblocking_connect_completion(channel_context *);
 
-  void handle_connect_succeed(channel_context *, std::shared_ptr<xxsocket>);
+  void handle_connect_succeed(event_loop *, channel_context *,
+                              std::shared_ptr<xxsocket>);
   void handle_connect_failed(channel_context *, int error);
 
-  void register_descriptor(const socket_native_type fd, int flags);
-  void unregister_descriptor(const socket_native_type fd, int flags);
-
   // The major async event-loop
-  void service(void);
+  void service(event_loop *);
+
+  // Add transport to the ready list, it will be performed at this or next
+  // event-loop iteration
+  void schedule_transport(const std::shared_ptr<channel_transport> &);
+
+  // perform read & write operations of the ready transports
+  void perform_transports(event_loop *);
+
+  // perform connect & accept operations of the active channels
+  void perform_active_channels(event_loop *);
 
   bool do_write(std::shared_ptr<channel_transport>);
   bool do_read(std::shared_ptr<channel_transport>);
-  void do_unpack(std::shared_ptr<channel_transport>, int bytes_expected,
-                 int bytes_transferred);
+  bool do_unpack(std::shared_ptr<channel_transport>);
+
+  // Handle the MSG_ZEROCOPY completions of socket error queue
+  void do_zerocopy_completion(std::shared_ptr<channel_transport>,
+                              socket_native_type fd);
+
+  // Keep the descriptor & zerocopy pdus of closing transport until the
+  // completions, and poll them at event-loop, the connection is reset after
+  // ZEROCOPY_LINGER_TIMEOUT.
+  void linger_zerocopy_pdus(std::shared_ptr<channel_transport>);
+  void perform_zerocopy_lingers(event_loop *);
+
+  // Submit the pdu to the event-loop of transport
+  bool write_pdu(std::shared_ptr<channel_transport>, a_pdu *);
+
+  // Pick the pdus from send lanes to send_queue_ before gather, and give back
+  // the unsent ones after send.
+  void pick_send_pdus(channel_transport *);
+  void unpick_send_pdus(channel_transport *);
+  int pick_send_lane(channel_transport *);
+
+  // Wake up the event-loop of transport to collect the submitted pdus
+  void notify_writing(std::shared_ptr<channel_transport>);
+
+  // Gives back the recv buffer of transport to the event-loop pool
+  void release_recv_buffer(channel_transport *);
 
   void handle_packet(std::shared_ptr<channel_transport> transport);
 
@@ -322,66 +707,79 @@ private:
 
   // @Optimize remember Application layer events to avoid call kernel API -->
   // ::select
-  int flush_ready_events();
+  int flush_ready_events(event_loop *);
+
+  void handle_send_finished(std::shared_ptr<channel_transport>, a_pdu_ptr,
+                            error_number);
+
+  // Invoke the writable callback if the write blocked transport drained
+  void check_writable(std::shared_ptr<channel_transport>);
+
+  // Arm or cancel the send timer of transport, and fail the expired pdus of
+  // lanes with ERR_SEND_TIMEOUT when it fired.
+  void update_send_timer(std::shared_ptr<channel_transport>);
+  void handle_send_timeout(std::shared_ptr<channel_transport>);
 
-  void handle_send_finished(a_pdu_ptr, error_number);
+  // Cancel the send timer and fail all the pdus of closed transport with
+  // ERR_CONNECTION_LOST, at event-loop thread.
+  void cancel_send_pdus(std::shared_ptr<channel_transport>);
 
   // supporting server
   void do_nonblocking_accept(channel_context *);
-  void do_nonblocking_accept_completion(fd_set *fds_array, channel_context *);
+  void do_nonblocking_accept_completion(channel_context *);
+  // Gets the number of connections can be accepted now by rate limit.
+  int refill_accept_tokens(channel_context *);
+  void perform_accepted_sockets(event_loop *);
 
   void swap_ready_events(channel_base *ctx);
 
 private:
   bool stopping_;
   bool thread_started_;
-  std::thread worker_thread_;
+
+  // The event-loops, only the first thread_count_ ones are running.
+  std::vector<std::unique_ptr<event_loop>> loops_;
+  int thread_count_;
+  std::atomic<unsigned int> next_loop_;
 
   long long connect_timeout_;
   long long send_timeout_;
   long long auto_reconnect_timeout_;
+  int listen_backlog_;
+  bool reuse_port_;
+  int accept_batch_size_;
+  int accept_rate_;
+  int accept_burst_;
+  int zerocopy_threshold_;
+  bool tcp_nodelay_;
+  size_t high_watermark_;
+  size_t low_watermark_;
+  int send_lane_weights_[SEND_LANE_COUNT];
 
   std::mutex recv_queue_mtx_;
-  std::deque<std::vector<char>> recv_queue_;
+  std::vector<recv_pdu_type> recv_queue_;
 
-  std::vector<channel_context *> channels_;
+  // The pdus taken from recv_queue_, only accessed by the dispatch thread
+  std::vector<recv_pdu_type> dispatching_queue_;
+  size_t dispatching_pos_;
 
-  std::mutex active_channels_mtx_;
-  std::vector<channel_context *> active_channels_;
+  // The transports have received pdus, per transport dispatch mode only
+  std::mutex dispatch_transports_mtx_;
+  std::condition_variable dispatch_transports_cv_;
+  std::deque<std::shared_ptr<channel_transport>> dispatch_transports_;
 
-  std::vector<std::shared_ptr<channel_transport>> transports_;
-
-  // select interrupter
-  select_interrupter interrupter_;
-
-  // timer support
-  std::vector<deadline_timer *> timer_queue_;
-  std::recursive_mutex timer_queue_mtx_;
-
-  // socket event set
-  int maxfdp_;
-  enum {
-    read_op,  // for async read and write(trigger by interrupt)
-    write_op, // for async connect
-    except_op,
-  };
-  fd_set fds_array_[3];
-
-  // Optimize record incomplete works
-  int nfds_;
+  std::vector<channel_context *> channels_;
 
   // callbacks
-  decode_pdu_length_func decode_pdu_length_;
+  std::shared_ptr<pdu_framer> framer_;
   connect_response_callback_t on_connect_resposne_;
   connection_lost_callback_t on_connection_lost_;
   recv_pdu_callback_t on_recv_pdu_;
+  recv_pdu_batch_callback_t on_recv_pdu_batch_;
+  transport_recv_pdu_callback_t on_recv_transport_pdu_;
+  transport_writable_callback_t on_transport_writable_;
   std::function<void(const vdcallback_t &)> tsf_call_;
 
-#if _USE_ARES_LIB
-  // non blocking io dns resolve support
-  void *ares_; //
-  int ares_count_;
-#endif
   int ipsv_state_; // local network state
 };                 // async_socket_io
 };                 // namespace inet
@@ -37,6 +37,18 @@ deadline_timer::~deadline_timer()
 {
 }
 
+void deadline_timer::expires_from_now(const std::chrono::microseconds& duration, bool repeated)
+{
+    this->duration_ = duration;
+    this->repeated_ = repeated;
+    expire_time_ = async_socket_io::now() + this->duration_;
+}
+
+void deadline_timer::expires_from_now()
+{
+    expire_time_ = async_socket_io::now() + this->duration_;
+}
+
 void deadline_timer::async_wait(const std::function<void(bool cancelled)>& callback)
 {
     this->callback_ = callback;
@@ -45,10 +57,98 @@ void deadline_timer::async_wait(const std::function<void(bool cancelled)>& callb
 
 void deadline_timer::cancel()
 {
-    if (!expired()) {
-        this->service_.cancel_timer(this);
+    // The timer may be expired by clock but not performed by event-loop yet,
+    // so whether in the timer queue decides.
+    if (this->service_.cancel_timer(this))
         this->expire();
+}
+
+bool deadline_timer::expired() const
+{
+    return wait_duration().count() <= 0;
+}
+
+void deadline_timer::expire()
+{
+    expire_time_ = async_socket_io::now() - duration_;
+}
+
+std::chrono::microseconds deadline_timer::wait_duration() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(expire_time_ - async_socket_io::now());
+}
+
+bool deadline_timer_queue::push(deadline_timer* timer)
+{
+    if (timer->heap_index_ >= 0)
+        return false;
+
+    heap_.push_back(timer);
+    place(heap_.size() - 1, timer);
+    sift_up(heap_.size() - 1);
+    return true;
+}
+
+bool deadline_timer_queue::erase(deadline_timer* timer)
+{
+    size_t index = static_cast<size_t>(timer->heap_index_);
+    if (timer->heap_index_ < 0 || index >= heap_.size() || heap_[index] != timer)
+        return false;
+
+    timer->heap_index_ = -1;
+    auto last = heap_.back();
+    heap_.pop_back();
+    if (index < heap_.size()) { // fill the hole with the last one
+        place(index, last);
+        sift_up(index);
+        sift_down(static_cast<size_t>(last->heap_index_));
+    }
+    return true;
+}
+
+deadline_timer* deadline_timer_queue::pop()
+{
+    auto earliest = heap_.front();
+    erase(earliest);
+    return earliest;
+}
+
+void deadline_timer_queue::sift_up(size_t index)
+{
+    auto timer = heap_[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 4;
+        if (!(timer->expire_time_ < heap_[parent]->expire_time_))
+            break;
+        place(index, heap_[parent]);
+        index = parent;
+    }
+    place(index, timer);
+}
+
+void deadline_timer_queue::sift_down(size_t index)
+{
+    auto timer = heap_[index];
+    const size_t count = heap_.size();
+    for (;;) {
+        size_t first_child = index * 4 + 1;
+        if (first_child >= count)
+            break;
+
+        // find the earliest one of the 4 children
+        size_t earliest = first_child;
+        size_t last_child = (std::min)(first_child + 4, count);
+        for (size_t child = first_child + 1; child < last_child; ++child) {
+            if (heap_[child]->expire_time_ < heap_[earliest]->expire_time_)
+                earliest = child;
+        }
+
+        if (!(heap_[earliest]->expire_time_ < timer->expire_time_))
+            break;
+        place(index, heap_[earliest]);
+        index = earliest;
     }
+    place(index, timer);
 }
 
 }
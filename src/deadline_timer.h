@@ -30,6 +30,7 @@ SOFTWARE.
 #define _XXSOCKET_DEADLINE_TIMER_H_
 #include <chrono>
 #include <functional>
+#include <vector>
 
 #if defined(_MSC_VER) && _MSC_VER < 1900
 typedef std::chrono::time_point<std::chrono::system_clock> compatible_timepoint_t;
@@ -41,55 +42,75 @@ namespace purelib
 {
 namespace inet {
 class async_socket_io;
+struct event_loop;
 class deadline_timer {
 public:
     ~deadline_timer();
-    deadline_timer(async_socket_io& service) : repeated_(false), service_(service)
+    deadline_timer(async_socket_io& service) : repeated_(false), service_(service), loop_(nullptr), heap_index_(-1)
     {
     }
 
-    void expires_from_now(const std::chrono::microseconds& duration, bool repeated = false)
-    {
-        this->duration_ = duration;
-        this->repeated_ = repeated;
-        expire_time_ = std::chrono::steady_clock::now() + this->duration_;
-    }
+    // The time is async_socket_io::now, the cached time of event-loop
+    // iteration at event-loop thread, i.e. the repeated timer.
+    void expires_from_now(const std::chrono::microseconds& duration, bool repeated = false);
 
-    void expires_from_now()
-    {
-        expire_time_ = std::chrono::steady_clock::now() + this->duration_;
-    }
+    void expires_from_now();
 
     // Wait timer timeout or cancelled.
     void async_wait(const std::function<void(bool cancelled)>& callback);
 
-    // Cancel the timer
+    // Cancel the timer if it's scheduled
     void cancel();
 
-    // Check if timer is expired?
-    bool expired() const
-    {
-        return wait_duration().count() <= 0;
-    }
+    // Check if timer is expired? compare with async_socket_io::now as the
+    // event-loop does.
+    bool expired() const;
 
     // Let timer expire immidlately
-    void expire()
-    {
-        expire_time_ = std::chrono::steady_clock::now() - duration_;
-    }
+    void expire();
 
     // Gets wait duration of timer.
-    std::chrono::microseconds wait_duration() const
-    {
-        return std::chrono::duration_cast<std::chrono::microseconds>(expire_time_ - std::chrono::steady_clock::now());
-    }
+    std::chrono::microseconds wait_duration() const;
 
     bool repeated_;
     async_socket_io& service_;
+    event_loop* loop_; // The event-loop which timer queue holds this timer
+    int heap_index_;   // The position in timer queue, -1: not scheduled
     std::chrono::microseconds duration_;
     compatible_timepoint_t expire_time_;
     std::function<void(bool cancelled)> callback_;
 };
+
+// The 4-ary min-heap of timers ordered by expire time, every timer remembers
+// it's position in the heap, so schedule & cancel are O(log n) without search.
+class deadline_timer_queue {
+public:
+    bool empty() const { return heap_.empty(); }
+    size_t size() const { return heap_.size(); }
+
+    // The earliest timer, the queue must not be empty.
+    deadline_timer* top() const { return heap_.front(); }
+
+    // Returns false when the timer is already in queue.
+    bool push(deadline_timer* timer);
+
+    // Returns false when the timer isn't in queue.
+    bool erase(deadline_timer* timer);
+
+    // Remove & return the earliest timer, the queue must not be empty.
+    deadline_timer* pop();
+
+private:
+    void sift_up(size_t index);
+    void sift_down(size_t index);
+    void place(size_t index, deadline_timer* timer)
+    {
+        heap_[index] = timer;
+        timer->heap_index_ = static_cast<int>(index);
+    }
+
+    std::vector<deadline_timer*> heap_;
+};
 }
 }
 
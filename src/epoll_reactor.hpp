@@ -0,0 +1,84 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_EPOLL_REACTOR_HPP
+#define XXSOCKET_EPOLL_REACTOR_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <sys/epoll.h>
+
+namespace purelib {
+namespace inet {
+
+// The linux reactor, level-triggered, no FD_SETSIZE limitation and the cost of
+// per wakeup only depends on the number of ready descriptors.
+class epoll_reactor : public io_reactor {
+public:
+  _XXSOCKET_INLINE epoll_reactor();
+
+  _XXSOCKET_INLINE ~epoll_reactor();
+
+  // Whether the epoll descriptor created successfully.
+  bool is_open() const { return epoll_fd_ != -1; }
+
+  const char *name() const override { return "epoll"; }
+
+  _XXSOCKET_INLINE void register_descriptor(socket_native_type fd,
+                                            int events) override;
+  _XXSOCKET_INLINE void unregister_descriptor(socket_native_type fd,
+                                              int events) override;
+
+  _XXSOCKET_INLINE int run_once(long long wait_usec) override;
+
+  _XXSOCKET_INLINE bool is_ready(socket_native_type fd,
+                                 int events) const override;
+
+private:
+  _XXSOCKET_INLINE void update_descriptor(socket_native_type fd, int events);
+
+  int epoll_fd_;
+
+  // The buffer of epoll_wait
+  std::vector<epoll_event> events_;
+
+  // The interest events of descriptors, index by fd
+  std::vector<int> interests_;
+
+  // The ready events of last run_once, index by fd
+  std::vector<int> revents_;
+};
+
+} // namespace inet
+} // namespace purelib
+
+#include "epoll_reactor.ipp"
+
+#endif // XXSOCKET_EPOLL_REACTOR_HPP
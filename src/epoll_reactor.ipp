@@ -0,0 +1,157 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_EPOLL_REACTOR_IPP
+#define XXSOCKET_EPOLL_REACTOR_IPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#define EPOLL_REACTOR_MAX_EVENTS 256
+
+namespace purelib {
+namespace inet {
+
+epoll_reactor::epoll_reactor() : events_(EPOLL_REACTOR_MAX_EVENTS) {
+#if defined(EPOLL_CLOEXEC)
+  epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+#else
+  epoll_fd_ = -1;
+  errno = EINVAL;
+#endif
+  if (epoll_fd_ == -1 && (errno == EINVAL || errno == ENOSYS)) {
+    epoll_fd_ = ::epoll_create(EPOLL_REACTOR_MAX_EVENTS);
+    if (epoll_fd_ != -1)
+      ::fcntl(epoll_fd_, F_SETFD, FD_CLOEXEC);
+  }
+}
+
+epoll_reactor::~epoll_reactor() {
+  if (epoll_fd_ != -1)
+    ::close(epoll_fd_);
+}
+
+void epoll_reactor::register_descriptor(socket_native_type fd, int events) {
+  if (fd < 0)
+    return;
+  if (static_cast<size_t>(fd) >= interests_.size()) {
+    interests_.resize(fd + 1, 0);
+    revents_.resize(fd + 1, 0);
+  }
+  update_descriptor(fd, interests_[fd] | events);
+}
+
+void epoll_reactor::unregister_descriptor(socket_native_type fd, int events) {
+  if (fd < 0 || static_cast<size_t>(fd) >= interests_.size())
+    return;
+  update_descriptor(fd, interests_[fd] & ~events);
+}
+
+void epoll_reactor::update_descriptor(socket_native_type fd, int events) {
+  int &interests = interests_[fd];
+  if (interests == events)
+    return;
+
+  epoll_event ev = {0, {0}};
+  ev.data.fd = fd;
+  if ((events & socket_event_read) != 0)
+    ev.events |= EPOLLIN;
+  if ((events & socket_event_write) != 0)
+    ev.events |= EPOLLOUT;
+  if ((events & socket_event_except) != 0)
+    ev.events |= EPOLLPRI;
+
+  if (events == 0) {
+    // The descriptor may be closed before unregister, it's removed from the
+    // epoll set by kernel automatically, so ignore the error.
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, &ev);
+  } else {
+    // The interests record may be out of date when a closed descriptor
+    // reused by new socket, so retry with the opposite operation.
+    if (interests == 0) {
+      if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) != 0 &&
+          errno == EEXIST)
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
+    } else {
+      if (::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev) != 0 &&
+          errno == ENOENT)
+        ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+    }
+  }
+
+  interests = events;
+}
+
+int epoll_reactor::run_once(long long wait_usec) {
+  for (auto &ev : ready_list_)
+    revents_[ev.fd] = 0;
+  ready_list_.clear();
+
+  // Round up to milliseconds, avoid waked up before the earliest timer
+  // expired.
+  int timeout_ms = static_cast<int>((wait_usec + 999) / 1000);
+  int nfds = ::epoll_wait(epoll_fd_, events_.data(),
+                          static_cast<int>(events_.size()), timeout_ms);
+  for (int i = 0; i < nfds; ++i) {
+    auto &ev = events_[i];
+    int fd = ev.data.fd;
+    if (static_cast<size_t>(fd) >= interests_.size())
+      continue;
+
+    int events = 0;
+    if ((ev.events & EPOLLIN) != 0)
+      events |= socket_event_read;
+    if ((ev.events & EPOLLOUT) != 0)
+      events |= socket_event_write;
+    if ((ev.events & EPOLLPRI) != 0)
+      events |= socket_event_except;
+    // Let the owner of descriptor detect the error by read or write.
+    if ((ev.events & (EPOLLERR | EPOLLHUP)) != 0)
+      events |= (interests_[fd] & (socket_event_read | socket_event_write));
+
+    revents_[fd] = events;
+    ready_list_.push_back(io_event{fd, events});
+  }
+
+  // All events buffer used, grow it for next wait.
+  if (nfds == static_cast<int>(events_.size()))
+    events_.resize(events_.size() << 1);
+
+  return nfds;
+}
+
+bool epoll_reactor::is_ready(socket_native_type fd, int events) const {
+  return fd >= 0 && static_cast<size_t>(fd) < revents_.size() &&
+         (revents_[fd] & events) != 0;
+}
+
+} // namespace inet
+} // namespace purelib
+
+#endif // XXSOCKET_EPOLL_REACTOR_IPP
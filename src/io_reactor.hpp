@@ -0,0 +1,120 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_IO_REACTOR_HPP
+#define XXSOCKET_IO_REACTOR_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include "xxsocket.h"
+#include <vector>
+
+#if !defined(_XXSOCKET_INLINE)
+#define _XXSOCKET_INLINE inline
+#endif
+
+// Whether use epoll as I/O event demultiplexer, linux only.
+#if !defined(_USE_EPOLL_REACTOR)
+#if defined(__linux__)
+#define _USE_EPOLL_REACTOR 1
+#else
+#define _USE_EPOLL_REACTOR 0
+#endif
+#endif
+
+namespace purelib {
+namespace inet {
+
+enum {
+  socket_event_read = 1,
+  socket_event_write = 2,
+  socket_event_except = 4,
+};
+
+struct io_event {
+  socket_native_type fd;
+  int events; // socket_event_xxx
+};
+
+// The I/O event demultiplexer of async_socket_io event-loop, all methods
+// must be called at event-loop thread.
+class io_reactor {
+public:
+  virtual ~io_reactor() {}
+
+  // The backend name, such as: 'select', 'epoll'
+  virtual const char *name() const = 0;
+
+  // Add or remove interest events of the descriptor.
+  virtual void register_descriptor(socket_native_type fd, int events) = 0;
+  virtual void unregister_descriptor(socket_native_type fd, int events) = 0;
+
+  // Wait I/O events at most wait_usec microseconds, 0: poll without blocking.
+  // Returns the number of ready descriptors, -1: error, check it by errno.
+  virtual int run_once(long long wait_usec) = 0;
+
+  // Whether any of the events of the descriptor is ready at last run_once.
+  virtual bool is_ready(socket_native_type fd, int events) const = 0;
+
+  // The ready descriptors of last run_once.
+  const std::vector<io_event> &ready_list() const { return ready_list_; }
+
+  // Create the best reactor of current platform, fallback to select.
+  static _XXSOCKET_INLINE io_reactor *create();
+
+protected:
+  std::vector<io_event> ready_list_;
+};
+
+} // namespace inet
+} // namespace purelib
+
+#include "select_reactor.hpp"
+#if _USE_EPOLL_REACTOR
+#include "epoll_reactor.hpp"
+#endif
+
+namespace purelib {
+namespace inet {
+
+io_reactor *io_reactor::create() {
+#if _USE_EPOLL_REACTOR
+  auto reactor = new epoll_reactor();
+  if (reactor->is_open())
+    return reactor;
+  delete reactor;
+#endif
+  return new select_reactor();
+}
+
+} // namespace inet
+} // namespace purelib
+
+#endif // XXSOCKET_IO_REACTOR_HPP
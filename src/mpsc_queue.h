@@ -0,0 +1,60 @@
+//
+// Copyright (c) 2014-2018 HALX99 - All Rights Reserved
+//
+#ifndef _MPSC_QUEUE_H_
+#define _MPSC_QUEUE_H_
+#include <atomic>
+
+namespace purelib {
+    namespace inet {
+
+        /// CLASS TEMPLATE mpsc_queue
+        /// The lock-free intrusive multi-producer single-consumer queue, the
+        /// node type must have a member: _Ty* next_.
+        /// The producers never block, the consumer takes all nodes at once.
+        template<typename _Ty>
+        class mpsc_queue
+        {
+        public:
+            mpsc_queue() : head_(nullptr) {}
+
+            // Returns true when the queue was empty, multi-producer safe.
+            bool push(_Ty* node)
+            {
+                auto head = head_.load(std::memory_order_relaxed);
+                do {
+                    node->next_ = head;
+                } while (!head_.compare_exchange_weak(head, node, std::memory_order_release, std::memory_order_relaxed));
+                return head == nullptr;
+            }
+
+            // Takes all nodes, returns the first one and the others are
+            // linked by next_ in FIFO order, single-consumer only.
+            _Ty* pop_all()
+            {
+                auto node = head_.exchange(nullptr, std::memory_order_acquire);
+                _Ty* first = nullptr;
+                while (node != nullptr) { // reverse the LIFO list
+                    auto next = node->next_;
+                    node->next_ = first;
+                    first = node;
+                    node = next;
+                }
+                return first;
+            }
+
+            bool empty() const
+            {
+                return head_.load(std::memory_order_relaxed) == nullptr;
+            }
+
+        private:
+            mpsc_queue(const mpsc_queue&) = delete;
+            mpsc_queue& operator=(const mpsc_queue&) = delete;
+
+            std::atomic<_Ty*> head_;
+        };
+    };
+};
+
+#endif
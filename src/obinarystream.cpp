@@ -24,9 +24,26 @@ obinarystream::~obinarystream()
 
 std::vector<char> obinarystream::take_buffer()
 {
+#if _USE_PDU_BUFFER
+	auto buffer = buffer_.to_vector();
+	buffer_ = buffer_type();
+	return buffer;
+#else
 	return std::move(buffer_);
+#endif
 };
 
+purelib::inet::pdu_buffer obinarystream::take_pdu_buffer()
+{
+#if _USE_PDU_BUFFER
+	return std::move(buffer_);
+#else
+	purelib::inet::pdu_buffer buffer(buffer_.data(), buffer_.data() + buffer_.size());
+	buffer_type().swap(buffer_);
+	return buffer;
+#endif
+}
+
 obinarystream& obinarystream::operator=(const obinarystream& right)
 {
 	buffer_ = right.buffer_;
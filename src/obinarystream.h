@@ -4,9 +4,24 @@
 #include <sstream>
 #include <vector>
 #include "endian_portable.h"
+#include "pdu_buffer.h"
+
+// Whether store the bytes by the slab allocated pdu_buffer, so the stream can
+// be taken by take_pdu_buffer and written without copy, default: the
+// std::vector<char>.
+#if !defined(_USE_PDU_BUFFER)
+#define _USE_PDU_BUFFER 0
+#endif
+
 class obinarystream
 {
 public:
+#if _USE_PDU_BUFFER
+    typedef purelib::inet::pdu_buffer buffer_type;
+#else
+    typedef std::vector<char> buffer_type;
+#endif
+
     obinarystream(size_t buffersize = 256);
     obinarystream(const obinarystream& right);
     obinarystream(obinarystream&& right);
@@ -15,8 +30,13 @@ public:
     obinarystream& operator=(const obinarystream& right);
     obinarystream& operator=(obinarystream&& right);
 
+    // Take the bytes without copy, only copies when _USE_PDU_BUFFER is 1.
     std::vector<char> take_buffer();
 
+    // Take the bytes as pdu_buffer, which can be sent by async_socket_io::write,
+    // only without copy when _USE_PDU_BUFFER is 1.
+    purelib::inet::pdu_buffer take_pdu_buffer();
+
     template<typename _Nty>
     size_t write_i(const _Nty value);
 
@@ -37,8 +57,10 @@ public:
     size_t length() const { return buffer_.size(); }
     const char* data() const { return buffer_.data(); }
 
-    const std::vector<char>& buffer() const { return buffer_; }
-    std::vector<char>& buffer() { return buffer_; }
+    // The std::vector<char> by default, the pdu_buffer when _USE_PDU_BUFFER
+    // is 1, whose copies share the bytes until written(copy on write).
+    const buffer_type& buffer() const { return buffer_; }
+    buffer_type& buffer() { return buffer_; }
     
     char* offsetp(size_t offset = 0) { return &buffer_.front() + offset; }
 
@@ -66,7 +88,7 @@ public:
     void save(const char* filename);
 
 protected:
-    std::vector<char>    buffer_;
+    buffer_type buffer_;
 };
 
 template <typename _Nty>
@@ -13,18 +13,25 @@ namespace gc {
 
 namespace detail {
 
-#define POOL_FL_BEGIN(chunk) reinterpret_cast <free_link_node*>(chunk->data)
-
-object_pool::object_pool(size_t element_size, size_t element_count) : free_link_(nullptr)
+#define POOL_SLOT_HEADER_SIZE sizeof(void*)
+#define POOL_SLOT_AT(chunk,index) reinterpret_cast<free_link_node*>(chunk->data + (index) * slot_size_)
+#define POOL_SLOT_ELEMENT(slot) (reinterpret_cast<char*>(slot) + POOL_SLOT_HEADER_SIZE)
+#define POOL_ELEMENT_SLOT(ptr) reinterpret_cast<free_link_node*>(reinterpret_cast<char*>(ptr) - POOL_SLOT_HEADER_SIZE)
+#define POOL_SLOT_OWNER(slot) (*reinterpret_cast<chunk_link*>(slot))
+#define POOL_POISON_BYTE 0xfd
+
+object_pool::object_pool(size_t element_size, size_t element_count) : avail_(nullptr)
     ,chunk_(nullptr)
     ,element_size_(element_size)
     ,element_count_(element_count)
-#ifdef _DEBUG
+    ,slot_size_(POOL_SLOT_HEADER_SIZE + element_size)
     ,allocated_count_(0)
-#endif
+    ,chunk_count_(0)
+    ,high_water_(0)
+    ,poison_(false)
 {
 #if OBJECT_POOL_PREALLOCATE
-    release(allocate_from_process_heap()); // preallocate 1 chunk
+    allocate_from_process_heap(); // preallocate 1 chunk
 #endif 
 }
 
@@ -35,27 +42,14 @@ object_pool::~object_pool(void)
 
 void object_pool::cleanup(void)
 {
-    if (this->chunk_ == nullptr) {
-        return;
-    }
-
-    chunk_link_node* chunk = this->chunk_;
-    free_link_node* linkend = this->tidy_chunk(chunk);
-
-    while ((chunk = chunk->next) != nullptr)
+    this->avail_ = nullptr;
+    for (chunk_link chunk = this->chunk_; chunk != nullptr; chunk = chunk->next)
     {
-        linkend->next = POOL_FL_BEGIN(chunk);
-
-        linkend = this->tidy_chunk(chunk);
+        this->tidy_chunk(chunk);
+        this->link_avail(chunk);
     }
 
-    linkend->next = nullptr;
-
-    this->free_link_ = POOL_FL_BEGIN(this->chunk_);
-
-#if defined(_DEBUG)
     this->allocated_count_ = 0;
-#endif
 }
 
 void object_pool::purge(void)
@@ -70,75 +64,148 @@ void object_pool::purge(void)
         free(p);
     }
 
-    free_link_ = nullptr;
+    avail_ = nullptr;
 
-#if defined(_DEBUG)
     allocated_count_ = 0;
-#endif
+    chunk_count_ = 0;
 }
 
 void* object_pool::get(void)
 {
-    if (this->free_link_ != nullptr)
+    chunk_link chunk = this->avail_;
+    if (chunk == nullptr)
+        chunk = allocate_from_process_heap();
+
+    free_link_node* slot = chunk->free_link;
+    chunk->free_link = slot->next;
+    if (chunk->free_link == nullptr) // the chunk is full
+        unlink_avail(chunk);
+    ++chunk->used;
+    POOL_SLOT_OWNER(slot) = chunk;
+
+    if (++this->allocated_count_ > this->high_water_)
+        this->high_water_ = this->allocated_count_;
+
+    void* ptr = POOL_SLOT_ELEMENT(slot);
+    if (this->poison_)
     {
-        return allocate_from_chunk();
+        auto bytes = reinterpret_cast<const unsigned char*>(ptr);
+        for (size_t i = 0; i < element_size_; ++i)
+        {
+            assert(bytes[i] == POOL_POISON_BYTE && "object_pool: the element was modified after release!");
+            if (bytes[i] != POOL_POISON_BYTE)
+                break;
+        }
     }
-
-    return allocate_from_process_heap();
+    return ptr;
 }
 
 void object_pool::release(void* _Ptr)
 {
-    free_link_node* ptr = reinterpret_cast<free_link_node*>(_Ptr);
-    ptr->next = this->free_link_;
-    this->free_link_ = ptr;
+    free_link_node* slot = POOL_ELEMENT_SLOT(_Ptr);
+    chunk_link chunk = POOL_SLOT_OWNER(slot);
+
+    if (this->poison_)
+        ::memset(_Ptr, POOL_POISON_BYTE, element_size_);
+
+    if (chunk->free_link == nullptr) // the chunk has free element again
+        link_avail(chunk);
+    slot->next = chunk->free_link;
+    chunk->free_link = slot;
+    --chunk->used;
 
-#if defined(_DEBUG)
     --this->allocated_count_;
-#endif
 }
 
-void* object_pool::allocate_from_process_heap(void)
+size_t object_pool::trim(size_t max_chunks)
 {
-    chunk_link new_chunk = (chunk_link)malloc(sizeof(chunk_link_node) + element_size_ * element_count_);
-#ifdef _DEBUG
-    ::memset(new_chunk, 0x00, sizeof(chunk_link_node));
-#endif
-    tidy_chunk(new_chunk)->next = nullptr;
+    size_t count = 0;
+    chunk_link_node *p, **q = &this->chunk_;
+    while (count < max_chunks && (p = *q) != nullptr)
+    {
+        if (p->used == 0)
+        {
+            *q = p->next;
+            unlink_avail(p);
+            free(p);
+            --this->chunk_count_;
+            ++count;
+        }
+        else
+            q = &p->next;
+    }
+    return count;
+}
+
+object_pool_stats object_pool::stats(void) const
+{
+    object_pool_stats stats;
+    stats.allocated = this->allocated_count_;
+    stats.free = this->chunk_count_ * this->element_count_ - this->allocated_count_;
+    stats.chunks = this->chunk_count_;
+    stats.high_water = this->high_water_;
+    return stats;
+}
+
+void object_pool::set_poison(bool poison)
+{
+    if (poison && !this->poison_)
+    { // poison the free elements
+        for (chunk_link chunk = this->chunk_; chunk != nullptr; chunk = chunk->next)
+        {
+            for (free_link_node* slot = chunk->free_link; slot != nullptr; slot = slot->next)
+                ::memset(POOL_SLOT_ELEMENT(slot), POOL_POISON_BYTE, element_size_);
+        }
+    }
+    this->poison_ = poison;
+}
+
+object_pool::chunk_link object_pool::allocate_from_process_heap(void)
+{
+    chunk_link new_chunk = (chunk_link)malloc(sizeof(chunk_link_node) + slot_size_ * element_count_);
+    tidy_chunk(new_chunk);
 
     // link the new_chunk
     new_chunk->next = this->chunk_;
     this->chunk_ = new_chunk;
+    ++this->chunk_count_;
 
-    // allocate 1 object
-    auto ptr = POOL_FL_BEGIN(new_chunk);
-    this->free_link_ = ptr->next;
-
-#if defined(_DEBUG)
-    ++this->allocated_count_;
-#endif
-    return reinterpret_cast<void*>(ptr);
+    link_avail(new_chunk);
+    return new_chunk;
 }
 
-void* object_pool::allocate_from_chunk(void)
+void object_pool::tidy_chunk(chunk_link chunk)
 {
-    free_link_node* ptr = this->free_link_;
-    this->free_link_ = ptr->next;
-#if defined(_DEBUG)
-    ++this->allocated_count_;
-#endif
-    return reinterpret_cast<void*>(ptr);
+    for (size_t i = 0; i < element_count_; ++i)
+    {
+        free_link_node* slot = POOL_SLOT_AT(chunk, i);
+        slot->next = (i + 1 < element_count_) ? POOL_SLOT_AT(chunk, i + 1) : nullptr;
+        if (this->poison_)
+            ::memset(POOL_SLOT_ELEMENT(slot), POOL_POISON_BYTE, element_size_);
+    }
+    chunk->free_link = POOL_SLOT_AT(chunk, 0);
+    chunk->used = 0;
+    chunk->avail_prev = chunk->avail_next = nullptr;
 }
 
-object_pool::free_link_node* object_pool::tidy_chunk(chunk_link chunk)
+void object_pool::link_avail(chunk_link chunk)
 {
-    char* rbegin = chunk->data + (element_count_ - 1) * element_size_;
+    chunk->avail_prev = nullptr;
+    chunk->avail_next = this->avail_;
+    if (this->avail_ != nullptr)
+        this->avail_->avail_prev = chunk;
+    this->avail_ = chunk;
+}
 
-    for (char* ptr = chunk->data; ptr < rbegin; ptr += element_size_)
-    {
-        reinterpret_cast<free_link_node*>(ptr)->next = reinterpret_cast<free_link_node*>(ptr + element_size_);
-    }
-    return reinterpret_cast <free_link_node*>(rbegin);
+void object_pool::unlink_avail(chunk_link chunk)
+{
+    if (chunk->avail_prev != nullptr)
+        chunk->avail_prev->avail_next = chunk->avail_next;
+    else if (this->avail_ == chunk)
+        this->avail_ = chunk->avail_next;
+    if (chunk->avail_next != nullptr)
+        chunk->avail_next->avail_prev = chunk->avail_prev;
+    chunk->avail_prev = chunk->avail_next = nullptr;
 }
 
 } // purelib::gc::detail
@@ -22,6 +22,14 @@ namespace gc {
 
 #define POOL_ESTIMATE_SIZE(element_type) sz_align(sizeof(element_type), sizeof(void*))
 
+struct object_pool_stats
+{
+    size_t allocated;  // the elements in use
+    size_t free;       // the free elements of all chunks
+    size_t chunks;     // the chunks allocated from process heap
+    size_t high_water; // the max elements in use
+};
+
 namespace detail {
     class object_pool
     {
@@ -30,9 +38,15 @@ namespace detail {
             free_link_node* next;
         } *free_link;
 
+        // Each chunk has it's own free link and occupancy, the chunks which
+        // have free elements are linked by avail_prev & avail_next.
         typedef struct chunk_link_node
         {
             chunk_link_node* next;
+            chunk_link_node* avail_prev;
+            chunk_link_node* avail_next;
+            free_link_node*  free_link;
+            size_t           used;
             char data[0];
         } *chunk_link;
 
@@ -51,21 +65,35 @@ namespace detail {
         OBJECT_POOL_DECL void* get(void);
         OBJECT_POOL_DECL void release(void* _Ptr);
 
+        // Return at most max_chunks fully free chunks to process heap,
+        // returns the number of chunks freed.
+        OBJECT_POOL_DECL size_t trim(size_t max_chunks = (size_t)-1);
+
+        OBJECT_POOL_DECL object_pool_stats stats(void) const;
+
+        // Debug mode, poison the freed elements, and check them when reuse
+        // to detect the writes after release.
+        OBJECT_POOL_DECL void set_poison(bool poison);
+
     private:
-        OBJECT_POOL_DECL void* allocate_from_chunk(void);
-        OBJECT_POOL_DECL void* allocate_from_process_heap(void);
-        
-        OBJECT_POOL_DECL free_link_node* tidy_chunk(chunk_link chunk);
+        OBJECT_POOL_DECL chunk_link allocate_from_process_heap(void);
+
+        OBJECT_POOL_DECL void tidy_chunk(chunk_link chunk);
+
+        OBJECT_POOL_DECL void link_avail(chunk_link chunk);
+        OBJECT_POOL_DECL void unlink_avail(chunk_link chunk);
 
     private:
-        free_link        free_link_; // link to free head
+        chunk_link       avail_; // link to the chunks which have free elements
         chunk_link       chunk_; // chunk link
         const size_t     element_size_;
         const size_t     element_count_;
+        const size_t     slot_size_; // slot header(owner chunk) + element
 
-#if defined(_DEBUG)
-        size_t           allocated_count_; // allocated count 
-#endif
+        size_t           allocated_count_; // allocated count
+        size_t           chunk_count_;
+        size_t           high_water_;
+        bool             poison_;
     };
     
 #define DEFINE_OBJECT_POOL_ALLOCATION(ELEMENT_TYPE,ELEMENT_COUNT) \
@@ -115,6 +143,30 @@ public: \
         return s_pool; \
     }
 
+// The thread cached edition, lock-free at most of allocations
+#define DEFINE_OBJECT_POOL_ALLOCATION3(ELEMENT_TYPE,ELEMENT_COUNT) \
+public: \
+    static void * operator new(size_t /*size*/) \
+    { \
+        return get_pool().allocate(); \
+    } \
+    \
+    static void * operator new(size_t /*size*/, std::nothrow_t) \
+    { \
+        return get_pool().allocate(); \
+    } \
+    \
+    static void operator delete(void *p) \
+    { \
+        get_pool().deallocate(p); \
+    } \
+    \
+    static purelib::gc::thread_cached_object_pool<ELEMENT_TYPE>& get_pool() \
+    { /* never destroyed, the thread caches may be flushed at exit */ \
+        static auto s_pool = new purelib::gc::thread_cached_object_pool<ELEMENT_TYPE>(ELEMENT_COUNT); \
+        return *s_pool; \
+    }
+
 #define DECLARE_OBJECT_POOL_ALLOCATION(ELEMENT_TYPE) \
 public: \
     static void * operator new(size_t /*size*/); \
@@ -211,6 +263,126 @@ public:
         release(_Ptr);
     }
 
+    size_t trim(size_t max_chunks = (size_t)-1)
+    {
+        std::lock_guard<std::mutex> lk(this->mutex_);
+        return detail::object_pool::trim(max_chunks);
+    }
+
+    object_pool_stats stats()
+    {
+        std::lock_guard<std::mutex> lk(this->mutex_);
+        return detail::object_pool::stats();
+    }
+
+    std::mutex mutex_;
+};
+
+// The thread cached edition, each thread caches at most 2 magazines of free
+// elements, the cache exchanges one magazine with the global depot by one
+// lock when it's empty or full, so the most of allocations are lock-free.
+// The caches are per type, there should be only one pool of a type, i.e.
+// the pool defined by DEFINE_OBJECT_POOL_ALLOCATION3.
+template<typename _Ty, size_t _MagazineSize = 32>
+class thread_cached_object_pool
+{
+    thread_cached_object_pool(const thread_cached_object_pool&) = delete;
+    void operator= (const thread_cached_object_pool&) = delete;
+
+    struct thread_cache
+    {
+        thread_cached_object_pool* owner = nullptr;
+        size_t count = 0;
+        void* elements[_MagazineSize * 2];
+
+        ~thread_cache()
+        { // return the cached elements to depot when thread exit
+            if (owner != nullptr)
+                owner->flush(*this, count);
+        }
+    };
+
+public:
+    thread_cached_object_pool(size_t _ElemCount = 512) : depot_(POOL_ESTIMATE_SIZE(_Ty), _ElemCount)
+    {
+    }
+
+    template<typename..._Args>
+    _Ty* construct(const _Args&...args)
+    {
+        return new (allocate()) _Ty(args...);
+    }
+
+    void destroy(void* _Ptr)
+    {
+        ((_Ty*)_Ptr)->~_Ty(); // call the destructor
+        deallocate(_Ptr);
+    }
+
+    void* allocate()
+    {
+        auto& cache = local_cache();
+        if (cache.owner != this)
+        { // not the pool of cache, use depot directly
+            std::lock_guard<std::mutex> lk(this->mutex_);
+            return depot_.get();
+        }
+
+        if (cache.count == 0)
+        { // load a magazine from depot
+            std::lock_guard<std::mutex> lk(this->mutex_);
+            for (; cache.count < _MagazineSize; ++cache.count)
+                cache.elements[cache.count] = depot_.get();
+        }
+        return cache.elements[--cache.count];
+    }
+
+    void deallocate(void* _Ptr)
+    {
+        auto& cache = local_cache();
+        if (cache.owner != this)
+        {
+            std::lock_guard<std::mutex> lk(this->mutex_);
+            depot_.release(_Ptr);
+            return;
+        }
+
+        if (cache.count == _MagazineSize * 2)
+            flush(cache, _MagazineSize); // return a magazine to depot
+        cache.elements[cache.count++] = _Ptr;
+    }
+
+    // The elements cached by threads are not free for depot, so they are
+    // counted as allocated and their chunks can't be trimmed.
+    size_t trim(size_t max_chunks = (size_t)-1)
+    {
+        std::lock_guard<std::mutex> lk(this->mutex_);
+        return depot_.trim(max_chunks);
+    }
+
+    object_pool_stats stats()
+    {
+        std::lock_guard<std::mutex> lk(this->mutex_);
+        return depot_.stats();
+    }
+
+private:
+    thread_cache& local_cache()
+    {
+        static thread_local thread_cache cache;
+        if (cache.owner == nullptr)
+            cache.owner = this;
+        return cache;
+    }
+
+    void flush(thread_cache& cache, size_t count)
+    {
+        std::lock_guard<std::mutex> lk(this->mutex_);
+        for (; count > 0; --count)
+            depot_.release(cache.elements[--cache.count]);
+    }
+
+    detail::object_pool depot_;
     std::mutex mutex_;
 };
 
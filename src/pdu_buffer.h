@@ -0,0 +1,305 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_PDU_BUFFER_H
+#define XXSOCKET_PDU_BUFFER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include "object_pool.h"
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
+
+namespace purelib {
+namespace gc {
+
+template <size_t _Size> struct slab_block {
+  char data[_Size];
+};
+
+// The size classed slab arena: 64, 128, ... 64K, each class is a thread
+// cached object pool, the larger blocks are allocated from process heap.
+class slab_arena {
+public:
+  enum {
+    min_block_size = 64,
+    max_block_size = 65536,
+    class_count = 11,
+  };
+
+  // Round up the size to it's slab class size.
+  static size_t block_size(size_t size) {
+    if (size > max_block_size)
+      return size;
+    size_t block = min_block_size;
+    while (block < size)
+      block <<= 1;
+    return block;
+  }
+
+  // The size must be rounded by block_size.
+  static void *allocate(size_t size) {
+    if (size > max_block_size)
+      return ::malloc(size);
+    return table()[class_index(size)].allocate();
+  }
+
+  static void deallocate(void *p, size_t size) {
+    if (size > max_block_size)
+      ::free(p);
+    else
+      table()[class_index(size)].deallocate(p);
+  }
+
+private:
+  struct slab_class {
+    void *(*allocate)();
+    void (*deallocate)(void *);
+  };
+
+  // The large blocks cached by thread are less, avoid occupy too many memory
+  template <size_t _Size> struct slab_pool {
+    enum {
+      magazine_size = _Size <= 2048 ? 32 : (65536 / _Size < 2 ? 2 : 65536 / _Size),
+      chunk_count = 262144 / _Size < 4 ? 4 : 262144 / _Size,
+    };
+    typedef thread_cached_object_pool<slab_block<_Size>, magazine_size>
+        pool_type;
+
+    // Never destroyed, the buffers may be released at static destruction.
+    static pool_type &get() {
+      static pool_type *s_pool = new pool_type(chunk_count);
+      return *s_pool;
+    }
+    static void *allocate() { return get().allocate(); }
+    static void deallocate(void *p) { get().deallocate(p); }
+  };
+
+  static int class_index(size_t size) {
+    int index = 0;
+    for (size_t block = min_block_size; block < size; block <<= 1)
+      ++index;
+    return index;
+  }
+
+  static const slab_class *table() {
+    static const slab_class s_table[class_count] = {
+        {&slab_pool<64>::allocate, &slab_pool<64>::deallocate},
+        {&slab_pool<128>::allocate, &slab_pool<128>::deallocate},
+        {&slab_pool<256>::allocate, &slab_pool<256>::deallocate},
+        {&slab_pool<512>::allocate, &slab_pool<512>::deallocate},
+        {&slab_pool<1024>::allocate, &slab_pool<1024>::deallocate},
+        {&slab_pool<2048>::allocate, &slab_pool<2048>::deallocate},
+        {&slab_pool<4096>::allocate, &slab_pool<4096>::deallocate},
+        {&slab_pool<8192>::allocate, &slab_pool<8192>::deallocate},
+        {&slab_pool<16384>::allocate, &slab_pool<16384>::deallocate},
+        {&slab_pool<32768>::allocate, &slab_pool<32768>::deallocate},
+        {&slab_pool<65536>::allocate, &slab_pool<65536>::deallocate},
+    };
+    return s_table;
+  }
+};
+
+} // namespace gc
+
+namespace inet {
+
+// The refcounted pdu bytes allocated from slab arena, copy shares the bytes,
+// all the non-const accessors copy the shared bytes first(copy on write), so
+// the owners never see the writes of each other, i.e. the pdu being sent by
+// event-loop. The pointers got before copy must not be written after it, as
+// the std::string of copy on write. It supports the vector like interfaces
+// used by pdu encoding & decoding.
+class pdu_buffer {
+  struct header {
+    std::atomic<int> refs;
+    unsigned int size;
+    unsigned int capacity;
+    unsigned int block_size;
+  };
+
+public:
+  typedef char value_type;
+  typedef char *iterator;
+  typedef const char *const_iterator;
+
+  pdu_buffer() : h_(nullptr) {}
+  explicit pdu_buffer(size_t size) : h_(nullptr) { resize(size); }
+  pdu_buffer(const char *first, const char *last) : h_(nullptr) {
+    assign(first, last);
+  }
+  pdu_buffer(const pdu_buffer &rhs) : h_(rhs.h_) {
+    if (h_ != nullptr)
+      ++h_->refs;
+  }
+  pdu_buffer(pdu_buffer &&rhs) : h_(rhs.h_) { rhs.h_ = nullptr; }
+  ~pdu_buffer() { release(); }
+
+  pdu_buffer &operator=(const pdu_buffer &rhs) {
+    pdu_buffer(rhs).swap(*this);
+    return *this;
+  }
+  pdu_buffer &operator=(pdu_buffer &&rhs) {
+    pdu_buffer(std::move(rhs)).swap(*this);
+    return *this;
+  }
+
+  void swap(pdu_buffer &rhs) { std::swap(h_, rhs.h_); }
+
+  char *data() {
+    unshare();
+    return h_ != nullptr ? bytes() : nullptr;
+  }
+  const char *data() const { return h_ != nullptr ? bytes() : nullptr; }
+  size_t size() const { return h_ != nullptr ? h_->size : 0; }
+  size_t capacity() const { return h_ != nullptr ? h_->capacity : 0; }
+  bool empty() const { return size() == 0; }
+  bool unique() const { return h_ == nullptr || h_->refs == 1; }
+
+  iterator begin() { return data(); }
+  iterator end() { return data() + size(); }
+  const_iterator begin() const { return data(); }
+  const_iterator end() const { return data() + size(); }
+  const_iterator cbegin() const { return data(); }
+  const_iterator cend() const { return data() + size(); }
+
+  char &front() { return *data(); }
+  char &operator[](size_t i) { return data()[i]; }
+  const char &operator[](size_t i) const { return data()[i]; }
+
+  void reserve(size_t n) {
+    if (n > capacity() || !unique())
+      reallocate((std::max)(n, size()));
+  }
+
+  void resize(size_t n) {
+    prepare(n);
+    if (h_ != nullptr)
+      h_->size = static_cast<unsigned int>(n);
+  }
+
+  void clear() {
+    if (unique()) {
+      if (h_ != nullptr)
+        h_->size = 0;
+    } else
+      release();
+  }
+
+  void assign(const char *first, const char *last) {
+    size_t n = last - first;
+    if (!unique() || n > capacity()) {
+      release();
+      reallocate(n);
+    }
+    if (n > 0)
+      ::memcpy(bytes(), first, n);
+    if (h_ != nullptr)
+      h_->size = static_cast<unsigned int>(n);
+  }
+
+  void append(const void *v, size_t n) {
+    size_t offset = size();
+    resize(offset + n);
+    if (n > 0)
+      ::memcpy(bytes() + offset, v, n);
+  }
+
+  iterator insert(const_iterator pos, const char *first, const char *last) {
+    size_t offset = pos - cbegin(); // the pos may be got before unshare
+    size_t n = last - first;
+    size_t tail = size() - offset;
+    resize(size() + n);
+    if (n > 0) {
+      ::memmove(bytes() + offset + n, bytes() + offset, tail);
+      ::memcpy(bytes() + offset, first, n);
+    }
+    return data() + offset;
+  }
+
+  void push_back(char c) { append(&c, 1); }
+
+  std::vector<char> to_vector() const {
+    return std::vector<char>(begin(), end());
+  }
+
+private:
+  char *bytes() const { return reinterpret_cast<char *>(h_ + 1); }
+
+  // Copy the shared bytes before write.
+  void unshare() {
+    if (!unique())
+      reallocate(capacity());
+  }
+
+  // Make sure the buffer is unique and can hold n bytes, grow by 2 times.
+  void prepare(size_t n) {
+    if (n > capacity())
+      reallocate((std::max)(n, capacity() * 2));
+    else if (!unique())
+      reallocate(capacity());
+  }
+
+  void reallocate(size_t n) {
+    if (n == 0 && h_ == nullptr)
+      return;
+    size_t block_size = gc::slab_arena::block_size(sizeof(header) + n);
+    auto h = static_cast<header *>(gc::slab_arena::allocate(block_size));
+    new (&h->refs) std::atomic<int>(1);
+    h->block_size = static_cast<unsigned int>(block_size);
+    h->capacity = static_cast<unsigned int>(block_size - sizeof(header));
+    h->size = 0;
+    if (h_ != nullptr) {
+      h->size = (std::min)(h_->size, h->capacity);
+      ::memcpy(reinterpret_cast<char *>(h + 1), bytes(), h->size);
+      release();
+    }
+    h_ = h;
+  }
+
+  void release() {
+    if (h_ != nullptr) {
+      if (--h_->refs == 0)
+        gc::slab_arena::deallocate(h_, h_->block_size);
+      h_ = nullptr;
+    }
+  }
+
+  header *h_;
+};
+
+} // namespace inet
+} // namespace purelib
+
+#endif // XXSOCKET_PDU_BUFFER_H
@@ -0,0 +1,178 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_PDU_FRAMER_H
+#define XXSOCKET_PDU_FRAMER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include <string.h>
+#include <string>
+
+namespace purelib {
+namespace inet {
+
+// The pdu framing engine, decodes the length of the pdu at head of recv
+// buffer, called at event-loop thread, one framer may be shared by many
+// transports, so the per transport scan state is passed by caller.
+class pdu_framer {
+public:
+  virtual ~pdu_framer() {}
+
+  // data: the unpacked bytes of recv buffer, begin with the pdu head.
+  // scanned: the bytes already examined by previous calls for the same pdu,
+  //          the framer updates it to skip them at next call, it's reset to 0
+  //          when a pdu decoded.
+  // Returns: > 0: the pdu length, 0: need more bytes, < 0: illegal pdu.
+  virtual int decode_length(const char *data, int datalen, int &scanned) = 0;
+};
+
+// The pdu begin with a fixed size header which contains the length field of
+// length_size(1~4) bytes at length_offset, the pdu length is:
+//   length field value + length_adjustment
+// i.e. length_adjustment is the header size when the field is body length.
+class fixed_header_framer : public pdu_framer {
+public:
+  fixed_header_framer(int length_offset, int length_size,
+                      bool big_endian = true, int length_adjustment = 0)
+      : length_offset_(length_offset), length_size_(length_size),
+        big_endian_(big_endian), length_adjustment_(length_adjustment) {}
+
+  int decode_length(const char *data, int datalen, int & /*scanned*/) override {
+    if (datalen < length_offset_ + length_size_)
+      return 0;
+
+    auto field = reinterpret_cast<const unsigned char *>(data) + length_offset_;
+    unsigned int value = 0;
+    if (big_endian_) {
+      for (int i = 0; i < length_size_; ++i)
+        value = (value << 8) | field[i];
+    } else {
+      for (int i = length_size_ - 1; i >= 0; --i)
+        value = (value << 8) | field[i];
+    }
+
+    long long len = static_cast<long long>(value) + length_adjustment_;
+    if (len <= 0 || len > 0x7fffffff)
+      return -1;
+    return static_cast<int>(len);
+  }
+
+private:
+  int length_offset_;
+  int length_size_;
+  bool big_endian_;
+  int length_adjustment_;
+};
+
+// The pdu begin with the varint(LEB128, at most 5 bytes) body length, the
+// pdu length is the varint bytes + body length.
+class varint_framer : public pdu_framer {
+public:
+  int decode_length(const char *data, int datalen, int & /*scanned*/) override {
+    auto ptr = reinterpret_cast<const unsigned char *>(data);
+    unsigned long long value = 0;
+    for (int i = 0; i < datalen; ++i) {
+      if (i == 5)
+        return -1;
+      value |= static_cast<unsigned long long>(ptr[i] & 0x7f) << (7 * i);
+      if ((ptr[i] & 0x80) == 0) {
+        value += i + 1;
+        return value <= 0x7fffffff ? static_cast<int>(value) : -1;
+      }
+    }
+    return 0;
+  }
+};
+
+// The pdu end with the delimiter, i.e. "\r\n\r\n" of http header, the pdu
+// length includes the delimiter. The bytes scanned never be scanned again.
+class delimiter_framer : public pdu_framer {
+public:
+  delimiter_framer(const char *delimiter, size_t len)
+      : delimiter_(delimiter, len) {}
+  delimiter_framer(const std::string &delimiter) : delimiter_(delimiter) {}
+
+  int decode_length(const char *data, int datalen, int &scanned) override {
+    int pos = find(data, datalen, scanned);
+    return pos >= 0 ? pos + static_cast<int>(delimiter_.size()) : 0;
+  }
+
+protected:
+  // Find the delimiter at [scanned, datalen), returns the offset of the
+  // delimiter or -1, the scanned is updated to the first unsure position.
+  int find(const char *data, int datalen, int &scanned) const {
+    const int dlen = static_cast<int>(delimiter_.size());
+    const char first = delimiter_[0];
+    int pos = scanned;
+    while (pos < datalen) {
+      // memchr is vectorized by the most of C runtime libraries
+      auto ptr = static_cast<const char *>(
+          ::memchr(data + pos, first, static_cast<size_t>(datalen - pos)));
+      if (ptr == nullptr) {
+        pos = datalen;
+        break;
+      }
+      pos = static_cast<int>(ptr - data);
+      if (datalen - pos < dlen)
+        break; // the delimiter may be incomplete, scan here next time.
+      if (::memcmp(ptr, delimiter_.c_str(), dlen) == 0)
+        return pos;
+      ++pos;
+    }
+    scanned = pos;
+    return -1;
+  }
+
+  std::string delimiter_;
+};
+
+// The adapter of legacy decode length function
+class function_framer : public pdu_framer {
+public:
+  typedef bool (*decode_pdu_length_func)(char *data, size_t datalen, int &len);
+
+  function_framer(decode_pdu_length_func func) : func_(func) {}
+
+  int decode_length(const char *data, int datalen, int & /*scanned*/) override {
+    int len = -1;
+    if (!func_(const_cast<char *>(data), datalen, len))
+      return -1;
+    return len > 0 ? len : 0;
+  }
+
+private:
+  decode_pdu_length_func func_;
+};
+
+} // namespace inet
+} // namespace purelib
+
+#endif // XXSOCKET_PDU_FRAMER_H
@@ -20,6 +20,8 @@
 #define _XXSOCKET_INLINE inline
 #endif
 
+#include <atomic>
+
 #if defined(_WIN32) 
 # include "socket_select_interrupter.hpp"
 #elif defined(__linux__)
@@ -31,12 +33,44 @@
 namespace purelib {
 namespace inet {
 
+// Coalesce the wakeups, only the first interrupt after reset writes to the
+// descriptor, the others find the wakeup pending and return immediately.
+template <typename Interrupter>
+class coalesced_select_interrupter : public Interrupter
+{
+public:
+  coalesced_select_interrupter()
+    : pending_(false)
+  {
+  }
+
+  // Interrupt the select call, skip the syscall if a wakeup is pending.
+  void interrupt()
+  {
+    if (!pending_.exchange(true, std::memory_order_acq_rel))
+      Interrupter::interrupt();
+  }
+
+  // Reset the select interrupt. Returns true if the call was interrupted.
+  // The pending flag is cleared after the descriptor drained, so the
+  // interrupts between them are handled by the caller's current iteration.
+  bool reset()
+  {
+    bool was_interrupted = Interrupter::reset();
+    pending_.exchange(false, std::memory_order_acq_rel);
+    return was_interrupted;
+  }
+
+private:
+  std::atomic<bool> pending_;
+};
+
 #if defined(_WIN32) 
-typedef socket_select_interrupter select_interrupter;
+typedef coalesced_select_interrupter<socket_select_interrupter> select_interrupter;
 #elif defined(__linux__)
-typedef eventfd_select_interrupter select_interrupter;
+typedef coalesced_select_interrupter<eventfd_select_interrupter> select_interrupter;
 #else
-typedef pipe_select_interrupter select_interrupter;
+typedef coalesced_select_interrupter<pipe_select_interrupter> select_interrupter;
 #endif
 
 } // namespace inet
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_SELECT_REACTOR_HPP
+#define XXSOCKET_SELECT_REACTOR_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+namespace purelib {
+namespace inet {
+
+// The portable reactor, limited by FD_SETSIZE
+class select_reactor : public io_reactor {
+public:
+  _XXSOCKET_INLINE select_reactor();
+
+  const char *name() const override { return "select"; }
+
+  _XXSOCKET_INLINE void register_descriptor(socket_native_type fd,
+                                            int events) override;
+  _XXSOCKET_INLINE void unregister_descriptor(socket_native_type fd,
+                                              int events) override;
+
+  _XXSOCKET_INLINE int run_once(long long wait_usec) override;
+
+  _XXSOCKET_INLINE bool is_ready(socket_native_type fd,
+                                 int events) const override;
+
+private:
+  _XXSOCKET_INLINE void collect_ready_list();
+
+  enum {
+    read_op,
+    write_op,
+    except_op,
+  };
+
+  // The registered descriptors
+  fd_set fds_array_[3];
+
+  // The ready descriptors of last run_once
+  fd_set ready_fds_array_[3];
+
+  int maxfdp_;
+};
+
+} // namespace inet
+} // namespace purelib
+
+#include "select_reactor.ipp"
+
+#endif // XXSOCKET_SELECT_REACTOR_HPP
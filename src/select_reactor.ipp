@@ -0,0 +1,139 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_SELECT_REACTOR_IPP
+#define XXSOCKET_SELECT_REACTOR_IPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+namespace purelib {
+namespace inet {
+
+select_reactor::select_reactor() : maxfdp_(0) {
+  FD_ZERO(&fds_array_[read_op]);
+  FD_ZERO(&fds_array_[write_op]);
+  FD_ZERO(&fds_array_[except_op]);
+  ::memcpy(ready_fds_array_, fds_array_, sizeof(fds_array_));
+}
+
+void select_reactor::register_descriptor(socket_native_type fd, int events) {
+  if ((events & socket_event_read) != 0) {
+    FD_SET(fd, &(fds_array_[read_op]));
+  }
+
+  if ((events & socket_event_write) != 0) {
+    FD_SET(fd, &(fds_array_[write_op]));
+  }
+
+  if ((events & socket_event_except) != 0) {
+    FD_SET(fd, &(fds_array_[except_op]));
+  }
+
+  if (maxfdp_ < static_cast<int>(fd) + 1)
+    maxfdp_ = static_cast<int>(fd) + 1;
+}
+
+void select_reactor::unregister_descriptor(socket_native_type fd,
+                                           int events) {
+  if ((events & socket_event_read) != 0) {
+    FD_CLR(fd, &(fds_array_[read_op]));
+  }
+
+  if ((events & socket_event_write) != 0) {
+    FD_CLR(fd, &(fds_array_[write_op]));
+  }
+
+  if ((events & socket_event_except) != 0) {
+    FD_CLR(fd, &(fds_array_[except_op]));
+  }
+}
+
+int select_reactor::run_once(long long wait_usec) {
+  ::memcpy(ready_fds_array_, fds_array_, sizeof(fds_array_));
+
+  timeval maxtv;
+  maxtv.tv_sec = static_cast<long>(wait_usec / 1000000);
+  maxtv.tv_usec = static_cast<long>(wait_usec % 1000000);
+  int nfds = ::select(this->maxfdp_, &(ready_fds_array_[read_op]),
+                      &(ready_fds_array_[write_op]),
+                      &(ready_fds_array_[except_op]), &maxtv);
+  if (nfds > 0)
+    collect_ready_list();
+  else {
+    ready_list_.clear();
+    if (nfds < 0) { // The ready sets are undefined when select failed.
+      FD_ZERO(&ready_fds_array_[read_op]);
+      FD_ZERO(&ready_fds_array_[write_op]);
+      FD_ZERO(&ready_fds_array_[except_op]);
+    }
+  }
+  return nfds;
+}
+
+bool select_reactor::is_ready(socket_native_type fd, int events) const {
+  return ((events & socket_event_read) != 0 &&
+          FD_ISSET(fd, &(ready_fds_array_[read_op]))) ||
+         ((events & socket_event_write) != 0 &&
+          FD_ISSET(fd, &(ready_fds_array_[write_op]))) ||
+         ((events & socket_event_except) != 0 &&
+          FD_ISSET(fd, &(ready_fds_array_[except_op])));
+}
+
+void select_reactor::collect_ready_list() {
+  ready_list_.clear();
+#if defined(_WIN32)
+  // The fd_set of winsock is a socket array, a socket may present in more than
+  // one set, the event-loop should handle it properly.
+  static const int op_events[] = {socket_event_read, socket_event_write,
+                                  socket_event_except};
+  for (int op = read_op; op <= except_op; ++op) {
+    auto &fds = ready_fds_array_[op];
+    for (u_int i = 0; i < fds.fd_count; ++i)
+      ready_list_.push_back(io_event{fds.fd_array[i], op_events[op]});
+  }
+#else
+  for (int fd = 0; fd < maxfdp_; ++fd) {
+    int events = 0;
+    if (FD_ISSET(fd, &(ready_fds_array_[read_op])))
+      events |= socket_event_read;
+    if (FD_ISSET(fd, &(ready_fds_array_[write_op])))
+      events |= socket_event_write;
+    if (FD_ISSET(fd, &(ready_fds_array_[except_op])))
+      events |= socket_event_except;
+    if (events != 0)
+      ready_list_.push_back(io_event{fd, events});
+  }
+#endif
+}
+
+} // namespace inet
+} // namespace purelib
+
+#endif // XXSOCKET_SELECT_REACTOR_IPP
@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_TIMERFD_TIMER_HPP
+#define XXSOCKET_TIMERFD_TIMER_HPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+#include "deadline_timer.h"
+#include <sys/timerfd.h>
+
+namespace purelib {
+namespace inet {
+
+// The linux timer descriptor, it becomes readable at the deadline with
+// nanoseconds precision, so the event-loop waits timers by reactor without
+// the precision limit of wait timeout, i.e. milliseconds of epoll_wait.
+class timerfd_timer {
+public:
+  _XXSOCKET_INLINE timerfd_timer();
+
+  _XXSOCKET_INLINE ~timerfd_timer();
+
+  // Whether the timer descriptor created successfully.
+  bool is_open() const { return fd_ != -1; }
+
+  // Get the descriptor to be registered to reactor.
+  int read_descriptor() const { return fd_; }
+
+  // Arm the timer at the time of steady_clock, it's ignored when the same
+  // deadline armed and not expired yet.
+  _XXSOCKET_INLINE void arm(const compatible_timepoint_t &deadline);
+
+  _XXSOCKET_INLINE void disarm();
+
+  // Clear the expiration after readable. Returns true if expired.
+  _XXSOCKET_INLINE bool reset();
+
+private:
+  _XXSOCKET_INLINE void set_time(long long nsec);
+
+  int fd_;
+  bool armed_;
+  compatible_timepoint_t deadline_;
+};
+
+} // namespace inet
+} // namespace purelib
+
+#include "timerfd_timer.ipp"
+
+#endif // XXSOCKET_TIMERFD_TIMER_HPP
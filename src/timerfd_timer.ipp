@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////////////////////
+// A cross platform socket APIs, support ios & android & wp8 & window store
+// universal app version: 3.3
+//////////////////////////////////////////////////////////////////////////////////////////
+/*
+The MIT License (MIT)
+
+Copyright (c) 2012-2018 halx99
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+#ifndef XXSOCKET_TIMERFD_TIMER_IPP
+#define XXSOCKET_TIMERFD_TIMER_IPP
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1200)
+#pragma once
+#endif // defined(_MSC_VER) && (_MSC_VER >= 1200)
+
+namespace purelib {
+namespace inet {
+
+timerfd_timer::timerfd_timer() : armed_(false) {
+  fd_ = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+}
+
+timerfd_timer::~timerfd_timer() {
+  if (fd_ != -1)
+    ::close(fd_);
+}
+
+void timerfd_timer::arm(const compatible_timepoint_t &deadline) {
+  if (armed_ && deadline == deadline_)
+    return;
+
+  // The steady_clock of linux is CLOCK_MONOTONIC, 0 disarms the timer.
+  auto nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  deadline.time_since_epoch())
+                  .count();
+  set_time(nsec > 0 ? nsec : 1);
+  armed_ = true;
+  deadline_ = deadline;
+}
+
+void timerfd_timer::disarm() {
+  if (armed_) {
+    set_time(0);
+    armed_ = false;
+  }
+}
+
+bool timerfd_timer::reset() {
+  uint64_t expirations = 0;
+  bool expired = ::read(fd_, &expirations, sizeof(expirations)) > 0;
+  if (expired)
+    armed_ = false;
+  return expired;
+}
+
+void timerfd_timer::set_time(long long nsec) {
+  itimerspec spec = {{0, 0}, {0, 0}};
+  spec.it_value.tv_sec = static_cast<time_t>(nsec / 1000000000);
+  spec.it_value.tv_nsec = static_cast<long>(nsec % 1000000000);
+  ::timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+}
+
+} // namespace inet
+} // namespace purelib
+
+#endif // XXSOCKET_TIMERFD_TIMER_IPP
@@ -36,6 +36,11 @@ SOFTWARE.
 #if !defined(_WIN32) && !defined(ANDROID)
 #include <ifaddrs.h>
 #endif
+#if defined(__linux__)
+#include <sys/sendfile.h>
+#elif defined(_WIN32)
+#include <io.h>
+#endif
 
 #if !defined(_WIN32) || defined(_WINSTORE)
 
@@ -936,6 +941,18 @@ xxsocket xxsocket::accept(socklen_t)
     return ::accept(this->fd, nullptr, nullptr);
 }
 
+xxsocket xxsocket::accept_nonblocking()
+{
+#if defined(__linux__) && defined(SOCK_NONBLOCK) && defined(SOCK_CLOEXEC)
+    return ::accept4(this->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
+    xxsocket result = this->accept();
+    if (result.is_open())
+        result.set_nonblocking(true);
+    return result;
+#endif
+}
+
 xxsocket xxsocket::accept_n(timeval* timeout)
 {
     xxsocket result;
@@ -1323,6 +1340,63 @@ int xxsocket::send_i(socket_native_type s, const void* buf, int len, int flags)
         flags);
 }
 
+int xxsocket::sendv_i(const socket_buffer_type* bufs, int count, int flags) const
+{
+#if defined(_WIN32)
+    DWORD bytes_sent = 0;
+    if (::WSASend(this->fd, const_cast<LPWSABUF>(bufs), count, &bytes_sent, static_cast<DWORD>(flags), nullptr, nullptr) != 0)
+        return SOCKET_ERROR;
+    return static_cast<int>(bytes_sent);
+#else
+    if (flags == 0)
+        return static_cast<int>(::writev(this->fd, bufs, count));
+
+    msghdr msg;
+    ::memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = const_cast<iovec*>(bufs);
+    msg.msg_iovlen = count;
+    return static_cast<int>(::sendmsg(this->fd, &msg, flags));
+#endif
+}
+
+int xxsocket::sendfile_i(int file_fd, long long offset, int len) const
+{
+#if defined(__linux__)
+    off_t off = static_cast<off_t>(offset);
+    return static_cast<int>(::sendfile(this->fd, file_fd, &off, static_cast<size_t>(len)));
+#elif defined(__APPLE__)
+    off_t bytes = len;
+    if (::sendfile(file_fd, this->fd, static_cast<off_t>(offset), &bytes, nullptr, 0) == 0 || bytes > 0)
+        return static_cast<int>(bytes); // EAGAIN with partial bytes sent
+    return -1;
+#else
+    char buf[SZ(16, K)];
+    if (len > static_cast<int>(sizeof(buf)))
+        len = static_cast<int>(sizeof(buf));
+#if defined(_WIN32)
+    if (::_lseeki64(file_fd, offset, SEEK_SET) == -1)
+        return -1;
+    int n = ::_read(file_fd, buf, len);
+#else
+    int n = static_cast<int>(::pread(file_fd, buf, len, static_cast<off_t>(offset)));
+#endif
+    if (n <= 0)
+        return n;
+    return this->send_i(buf, n);
+#endif
+}
+
+void xxsocket::set_buffer(socket_buffer_type& buf, const void* data, int len)
+{
+#if defined(_WIN32)
+    buf.buf = (CHAR*)data;
+    buf.len = static_cast<ULONG>(len);
+#else
+    buf.iov_base = const_cast<void*>(data);
+    buf.iov_len = static_cast<size_t>(len);
+#endif
+}
+
 int xxsocket::recv_i(void* buf, int len, int flags) const
 {
     return recv_i(this->fd, buf, len, flags);
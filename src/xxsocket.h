@@ -57,6 +57,7 @@ SOFTWARE.
 #include <Wspiapi.h>
 typedef SOCKET socket_native_type; 
 typedef int socklen_t;
+typedef WSABUF socket_buffer_type;
 #pragma comment(lib, "ws2_32.lib")
 #else
 #include <unistd.h>
@@ -68,6 +69,8 @@ typedef int socklen_t;
 // #include <sys/epoll.h>
 #include <sys/select.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <limits.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <net/if.h>
@@ -88,10 +91,16 @@ typedef int socklen_t;
 #define ioctlsocket ioctl
 #endif
 typedef int socket_native_type;
+typedef struct iovec socket_buffer_type;
 #undef socket
 #endif
 #include <fcntl.h> // common platform header
 
+// The max number of buffers of one gather send
+#if !defined(IOV_MAX)
+#define IOV_MAX 1024
+#endif
+
 // redefine socket error code for posix api
 #ifdef _WIN32
 
@@ -647,6 +656,17 @@ public:
     */
     xxsocket accept(socklen_t addrlen = sizeof(sockaddr));
 
+    /* @brief: Permits an incoming connection attempt on this socket, the new
+    **         socket is non-blocking & close-on-exec, on linux, use accept4
+    **         to set them without extra syscalls.
+    **
+    ** @returns:
+    **        If no error occurs, accept returns a new socket on which
+    **        the actual connection is made.
+    **        Otherwise, a value of [nullptr] is returned
+    */
+    xxsocket accept_nonblocking();
+
 
     /* @brief: Permits an incoming connection attempt on this socket
     ** @params: 
@@ -750,6 +770,31 @@ public:
     int send_i(const void* buf, int len, int flags = 0) const;
     static int send_i(socket_native_type fd, const void* buf, int len, int flags = 0);
 
+    /* @brief: Sends the data of buffers on this connected socket with one syscall,
+    **         writev on posix, WSASend on win32.
+    ** @params:
+    **         bufs: the buffers, set by xxsocket::set_buffer
+    **         count: the number of buffers, must not greater than IOV_MAX
+    **         flags: the flags of sendmsg, i.e. MSG_ZEROCOPY
+    **
+    ** @returns:
+    **         same as send_i
+    */
+    int sendv_i(const socket_buffer_type* bufs, int count, int flags = 0) const;
+    static void set_buffer(socket_buffer_type& buf, const void* data, int len);
+
+    /* @brief: Sends the file segment on this connected socket without user space copy,
+    **         sendfile on linux & apple, read & send on other platforms.
+    ** @params:
+    **         file_fd: the file descriptor opened for reading
+    **         offset: the file offset of the bytes to send, the file position is not changed
+    **         len: the max bytes to send
+    **
+    ** @returns:
+    **         the bytes sent, [0]: the offset reaches end of file, [-1]: error, see get_last_errno
+    */
+    int sendfile_i(int file_fd, long long offset, int len) const;
+
 
     /* @brief: Receives data from this connected socket or a bound connectionless socket. 
     ** @params: omit
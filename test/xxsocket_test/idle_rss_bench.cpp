@@ -0,0 +1,101 @@
+// The RSS per idle server connection, each client sends one pdu then keeps
+// the connection idle, so every transport has received once and given back
+// it's recv buffer.
+//
+// build(linux): g++ -std=c++11 -O2 -I../../src idle_rss_bench.cpp
+//   ../../src/async_socket_io.cpp ../../src/xxsocket.cpp
+//   ../../src/deadline_timer.cpp -lcares -lpthread -o idle_rss_bench
+// usage: idle_rss_bench [connections=5000] [thread_count=1]
+#include "async_socket_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#include <atomic>
+
+using namespace purelib::inet;
+
+static long long resident_bytes() {
+    long long pages = 0, resident = 0;
+    FILE *fp = fopen("/proc/self/statm", "r");
+    if (fp != nullptr) {
+        if (fscanf(fp, "%lld %lld", &pages, &resident) != 2)
+            resident = 0;
+        fclose(fp);
+    }
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+static bool decode_pdu_length(char *data, size_t datalen, int &len) {
+    len = datalen >= 1 ? static_cast<unsigned char>(data[0]) : -1;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    int connections = argc > 1 ? atoi(argv[1]) : 5000;
+    int thread_count = argc > 2 ? atoi(argv[2]) : 1;
+
+    // Every connection takes 2 descriptors, the client and server ends.
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        int max_connections = static_cast<int>((limit.rlim_cur - 64) / 2);
+        if (connections > max_connections)
+            connections = max_connections;
+    }
+
+    std::atomic<int> accepted(0), received(0);
+    channel_endpoint ep = {"0.0.0.0", 36993};
+    myasio->set_callbacks(
+        decode_pdu_length,
+        [&](size_t, std::shared_ptr<channel_transport> transport, int ec) {
+            if (ec == 0 && transport)
+                ++accepted;
+        },
+        [](std::shared_ptr<channel_transport>) {},
+        [&](recv_pdu_type &&) { ++received; },
+        [](const vdcallback_t &callback) { callback(); });
+    myasio->start_service(&ep, 1, thread_count);
+    myasio->open(0, CHANNEL_TCP_SERVER);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::vector<std::unique_ptr<xxsocket>> clients;
+    clients.reserve(connections);
+    long long rss_before = resident_bytes();
+
+    const char pdu[16] = {16};
+    linger abort_close = {1, 0}; // reset, no TIME_WAIT on client side
+    ip::endpoint peer("127.0.0.1", 36993);
+    for (int i = 0; i < connections; ++i) {
+        std::unique_ptr<xxsocket> client(new xxsocket());
+        if (!client->open() || client->connect(peer) != 0) {
+            printf("connect failed at %d, error: %d\n", i,
+                   xxsocket::get_last_errno());
+            break;
+        }
+        client->set_optval(SOL_SOCKET, SO_LINGER, abort_close);
+        client->send_i(pdu, sizeof(pdu));
+        clients.push_back(std::move(client));
+    }
+
+    const int total = static_cast<int>(clients.size());
+    for (int i = 0; i < 1000 && (accepted < total || received < total); ++i) {
+        myasio->dispatch_received_pdu(1000000);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    long long rss_after = resident_bytes();
+
+    printf("%d idle connections, accepted=%d received=%d, rss: %.1fMB --> "
+           "%.1fMB, %.0f bytes per connection\n",
+           total, (int)accepted, (int)received, rss_before / 1048576.0,
+           rss_after / 1048576.0,
+           total > 0 ? static_cast<double>(rss_after - rss_before) / total : 0);
+
+    clients.clear();
+    myasio->close(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    myasio->stop_service();
+    return 0;
+}
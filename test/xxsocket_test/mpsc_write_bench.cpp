@@ -0,0 +1,178 @@
+// The write throughput of 8 producer threads writing to one transport, and
+// the submission cost of the lock-free mpsc_queue vs the legacy
+// recursive_mutex queue which the event-loop held while sending.
+//
+// build: g++ -std=c++11 -O2 -I../../src mpsc_write_bench.cpp
+//   ../../src/async_socket_io.cpp ../../src/xxsocket.cpp
+//   ../../src/deadline_timer.cpp -lcares -lpthread -o mpsc_write_bench
+// usage: mpsc_write_bench [producers=8] [pdus_per_producer=200000]
+//   [pdu_size=64]
+#include "async_socket_io.h"
+#include "mpsc_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <deque>
+
+using namespace purelib::inet;
+
+struct node {
+    node *next_ = nullptr;
+};
+
+static double elapsed_ms(const std::chrono::steady_clock::time_point &start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - start)
+               .count() /
+           1000.0;
+}
+
+// Submit nodes from producers to one consumer, the consumer takes them by
+// take(), returns the elapsed milliseconds.
+template <typename _Submit, typename _Take>
+static double run_queue(int producers, int count, _Submit submit, _Take take) {
+    std::vector<node> nodes(static_cast<size_t>(producers) * count);
+    std::atomic<long long> taken(0);
+    const long long total = static_cast<long long>(nodes.size());
+
+    auto start = std::chrono::steady_clock::now();
+    std::thread consumer([&] {
+        while (taken < total)
+            taken += take();
+    });
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&, p] {
+            for (int i = 0; i < count; ++i)
+                submit(&nodes[static_cast<size_t>(p) * count + i]);
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+    consumer.join();
+    return elapsed_ms(start);
+}
+
+static void bench_queues(int producers, int count) {
+    mpsc_queue<node> lockfree;
+    double lockfree_ms = run_queue(
+        producers, count, [&](node *n) { lockfree.push(n); },
+        [&]() {
+            int n = 0;
+            for (auto p = lockfree.pop_all(); p != nullptr; p = p->next_)
+                ++n;
+            return n;
+        });
+
+    // The legacy queue, the consumer holds the lock while taking all nodes
+    // as do_write did.
+    std::recursive_mutex mtx;
+    std::deque<node *> locked;
+    double locked_ms = run_queue(
+        producers, count,
+        [&](node *n) {
+            std::lock_guard<std::recursive_mutex> lk(mtx);
+            locked.push_back(n);
+        },
+        [&]() {
+            std::lock_guard<std::recursive_mutex> lk(mtx);
+            int n = static_cast<int>(locked.size());
+            locked.clear();
+            return n;
+        });
+
+    double total = static_cast<double>(producers) * count;
+    printf("submit queue, %d producers: mpsc_queue %.1f M/s, "
+           "recursive_mutex %.1f M/s\n",
+           producers, total / lockfree_ms / 1000, total / locked_ms / 1000);
+}
+
+static bool decode_pdu_length(char *data, size_t datalen, int &len) {
+    if (datalen >= 4) {
+        uint32_t n;
+        memcpy(&n, data, 4);
+        len = static_cast<int>(ntohl(n));
+    }
+    else
+        len = -1;
+    return true;
+}
+
+static void bench_transport(int producers, int count, int pdu_size) {
+    std::atomic<long long> received(0);
+    std::shared_ptr<channel_transport> client;
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    channel_endpoint eps[] = {
+        {"127.0.0.1", 36992}, // client
+        {"0.0.0.0", 36992},   // server
+    };
+    myasio->set_callbacks(
+        decode_pdu_length,
+        [&](size_t index, std::shared_ptr<channel_transport> transport,
+            int ec) {
+            if (index == 0 && ec == 0) {
+                std::lock_guard<std::mutex> lk(mtx);
+                client = transport;
+                cv.notify_one();
+            }
+        },
+        [](std::shared_ptr<channel_transport>) {}, [](recv_pdu_type &&) {},
+        [](const vdcallback_t &callback) { callback(); });
+    myasio->set_recv_batch_callback(
+        [&](recv_pdu_type *, size_t n) { received += n; });
+    myasio->start_service(eps, _ARRAYSIZE(eps));
+    myasio->open(1, CHANNEL_TCP_SERVER);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    myasio->open(0, CHANNEL_TCP_CLIENT);
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        if (!cv.wait_for(lk, std::chrono::seconds(5),
+                         [&] { return client != nullptr; })) {
+            printf("connect failed!\n");
+            return;
+        }
+    }
+
+    std::vector<char> pdu(static_cast<size_t>(pdu_size), 'x');
+    uint32_t n = htonl(static_cast<uint32_t>(pdu_size));
+    memcpy(pdu.data(), &n, 4);
+
+    const long long total = static_cast<long long>(producers) * count;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < count; ++i)
+                myasio->write(client, std::vector<char>(pdu));
+        });
+    }
+    for (auto &t : threads)
+        t.join();
+    double write_ms = elapsed_ms(start);
+    while (received < total && elapsed_ms(start) < 60000)
+        myasio->dispatch_received_pdu(1000000);
+    double ms = elapsed_ms(start);
+
+    printf("transport, %d producers x %d pdus of %d bytes: writes done in "
+           "%.0fms, received %lld in %.0fms, %.2f M pdus/s, %.0f MB/s\n",
+           producers, count, pdu_size, write_ms,
+           (long long)received.load(), ms, received / ms / 1000,
+           received * pdu_size / ms / 1000);
+
+    myasio->close(client);
+    myasio->close(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    myasio->stop_service();
+}
+
+int main(int argc, char **argv) {
+    int producers = argc > 1 ? atoi(argv[1]) : 8;
+    int count = argc > 2 ? atoi(argv[2]) : 200000;
+    int pdu_size = argc > 3 ? (std::max)(atoi(argv[3]), 4) : 64;
+
+    bench_queues(producers, count);
+    bench_transport(producers, count, pdu_size);
+    return 0;
+}
@@ -0,0 +1,86 @@
+// The connects/sec benchmark of the server channel, one listener hands off
+// the accepted connections vs one SO_REUSEPORT listener per event-loop.
+//
+// build(linux): g++ -std=c++11 -O2 -I../../src reuseport_bench.cpp
+//   ../../src/async_socket_io.cpp ../../src/xxsocket.cpp
+//   ../../src/deadline_timer.cpp -lcares -lpthread -o reuseport_bench
+// usage: reuseport_bench [thread_count=4] [client_threads=8] [seconds=3]
+#include "async_socket_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+
+using namespace purelib::inet;
+
+static bool decode_pdu_length(char *, size_t, int &len) {
+    len = -1;
+    return true;
+}
+
+static void run(bool reuse_port, u_short port, int thread_count,
+                int client_threads, int seconds) {
+    async_socket_io service;
+    std::atomic<long long> accepted(0);
+
+    channel_endpoint ep = {"0.0.0.0", port};
+    service.set_reuse_port(reuse_port);
+    service.set_callbacks(
+        decode_pdu_length,
+        [&](size_t, std::shared_ptr<channel_transport> transport, int ec) {
+            if (ec == 0 && transport)
+                ++accepted;
+        },
+        [](std::shared_ptr<channel_transport>) {}, [](recv_pdu_type &&) {},
+        [](const vdcallback_t &callback) { callback(); });
+    service.start_service(&ep, 1, thread_count);
+    service.open(0, CHANNEL_TCP_SERVER);
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    std::atomic<bool> stopping(false);
+    std::atomic<long long> connected(0), failed(0);
+    std::vector<std::thread> clients;
+    for (int i = 0; i < client_threads; ++i) {
+        clients.emplace_back([&] {
+            ip::endpoint peer("127.0.0.1", port);
+            linger abort_close = {1, 0}; // reset, no TIME_WAIT on client side
+            while (!stopping) {
+                xxsocket s;
+                if (s.open() && s.connect(peer) == 0) {
+                    s.set_optval(SOL_SOCKET, SO_LINGER, abort_close);
+                    ++connected;
+                }
+                else
+                    ++failed;
+            }
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    stopping = true;
+    for (auto &t : clients)
+        t.join();
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    printf("%-10s loops=%d clients=%d: %.0f connects/sec, accepted=%lld, "
+           "failed=%lld\n",
+           reuse_port ? "reuseport" : "single", thread_count, client_threads,
+           connected * 1e6 / elapsed, (long long)accepted,
+           (long long)failed);
+
+    service.close(0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    service.stop_service();
+}
+
+int main(int argc, char **argv) {
+    int thread_count = argc > 1 ? atoi(argv[1]) : 4;
+    int client_threads = argc > 2 ? atoi(argv[2]) : 8;
+    int seconds = argc > 3 ? atoi(argv[3]) : 3;
+
+    run(false, 36990, thread_count, client_threads, seconds);
+    run(true, 36991, thread_count, client_threads, seconds);
+    return 0;
+}
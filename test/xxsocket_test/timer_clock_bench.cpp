@@ -0,0 +1,104 @@
+// The per-iteration cost of checking 10k timers by reading the clock per
+// timer(the legacy deadline_timer::expired & the sort by wait_duration of
+// perform_timeout_timers) vs comparing with the time sampled once per
+// event-loop iteration.
+//
+// build: g++ -std=c++11 -O2 -I../../src timer_clock_bench.cpp
+//   ../../src/async_socket_io.cpp ../../src/xxsocket.cpp
+//   ../../src/deadline_timer.cpp -lcares -lpthread -o timer_clock_bench
+// usage: timer_clock_bench [timers=10000] [iterations=200]
+#include "async_socket_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+#if defined(__linux__)
+#include <time.h>
+#endif
+
+using namespace purelib::inet;
+
+// Prevent the checks being optimized out
+static volatile long long s_sink = 0;
+
+template <typename _Fn> static double measure_ns(int iterations, _Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i)
+        fn();
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+               .count() /
+           static_cast<double>(iterations);
+}
+
+int main(int argc, char **argv) {
+    int count = argc > 1 ? atoi(argv[1]) : 10000;
+    int iterations = argc > 2 ? atoi(argv[2]) : 200;
+
+    async_socket_io service; // not started, only the timers owner
+    std::mt19937 rng(2018);
+    std::uniform_int_distribution<int> random_msec(1, 60000);
+    std::vector<std::unique_ptr<deadline_timer>> timers;
+    for (int i = 0; i < count; ++i) {
+        timers.emplace_back(new deadline_timer(service));
+        timers.back()->expires_from_now(
+            std::chrono::milliseconds(random_msec(rng)));
+    }
+
+    double steady_ns = measure_ns(iterations * 100, [] {
+        s_sink += std::chrono::steady_clock::now().time_since_epoch().count();
+    });
+    printf("steady_clock::now: %.1f ns\n", steady_ns);
+#if defined(__linux__) && defined(CLOCK_MONOTONIC_COARSE)
+    double coarse_ns = measure_ns(iterations * 100, [] {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+        s_sink += ts.tv_nsec;
+    });
+    printf("CLOCK_MONOTONIC_COARSE: %.1f ns\n", coarse_ns);
+#endif
+
+    // Check every timer whether expired
+    double per_timer_ns = measure_ns(iterations, [&] {
+        long long n = 0;
+        for (auto &timer : timers)
+            n += std::chrono::steady_clock::now() >= timer->expire_time_;
+        s_sink += n;
+    });
+    double cached_ns = measure_ns(iterations, [&] {
+        auto now = async_socket_io::now();
+        long long n = 0;
+        for (auto &timer : timers)
+            n += !(now < timer->expire_time_);
+        s_sink += n;
+    });
+    printf("check %d timers per iteration: clock per timer %.1f us, "
+           "cached clock %.1f us\n",
+           count, per_timer_ns / 1000, cached_ns / 1000);
+
+    // The legacy perform_timeout_timers sorted the queue by wait_duration,
+    // which reads the clock twice per comparison.
+    std::vector<deadline_timer *> queue;
+    for (auto &timer : timers)
+        queue.push_back(timer.get());
+    std::vector<deadline_timer *> sorting;
+    double sort_clock_ns = measure_ns(iterations, [&] {
+        sorting = queue;
+        std::sort(sorting.begin(), sorting.end(),
+                  [](deadline_timer *lhs, deadline_timer *rhs) {
+                      auto now = std::chrono::steady_clock::now();
+                      return lhs->expire_time_ - now > rhs->expire_time_ - now;
+                  });
+    });
+    double sort_cached_ns = measure_ns(iterations, [&] {
+        sorting = queue;
+        std::sort(sorting.begin(), sorting.end(),
+                  [](deadline_timer *lhs, deadline_timer *rhs) {
+                      return lhs->expire_time_ > rhs->expire_time_;
+                  });
+    });
+    printf("sort %d timers per iteration: clock per comparison %.1f us, "
+           "without clock %.1f us\n",
+           count, sort_clock_ns / 1000, sort_cached_ns / 1000);
+    return 0;
+}
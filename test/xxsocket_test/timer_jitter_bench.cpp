@@ -0,0 +1,106 @@
+// The wakeup jitter histogram of a repeated 1ms timer, the lateness is the
+// time of callback after the deadline, a negative one is an early wakeup.
+// Build it with the reactor wait timeout(default), and with timerfd to
+// compare:
+//
+// build(linux): g++ -std=c++11 -O2 -I../../src timer_jitter_bench.cpp
+//   ../../src/async_socket_io.cpp ../../src/xxsocket.cpp
+//   ../../src/deadline_timer.cpp -lcares -lpthread -o timer_jitter_bench
+//   add -D_USE_TIMERFD=1 for timerfd, -D_USE_EPOLL_REACTOR=0 for select.
+// usage: timer_jitter_bench [ticks=2000] [interval_usec=1000]
+#include "async_socket_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+
+using namespace purelib::inet;
+
+static bool decode_pdu_length(char *, size_t, int &len) {
+    len = -1;
+    return true;
+}
+
+int main(int argc, char **argv) {
+    const int ticks = argc > 1 ? atoi(argv[1]) : 2000;
+    const int interval = argc > 2 ? atoi(argv[2]) : 1000;
+
+    channel_endpoint ep = {"127.0.0.1", 36997};
+    myasio->set_callbacks(
+        decode_pdu_length,
+        [](size_t, std::shared_ptr<channel_transport>, int) {},
+        [](std::shared_ptr<channel_transport>) {}, [](recv_pdu_type &&) {},
+        [](const vdcallback_t &callback) { callback(); });
+    myasio->start_service(&ep, 1);
+
+    std::vector<long long> lateness;
+    lateness.reserve(ticks);
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    deadline_timer timer(*myasio);
+    timer.expires_from_now(std::chrono::microseconds(interval), true);
+    timer.async_wait([&](bool cancelled) {
+        if (cancelled)
+            return;
+        // The deadline is updated after the callback for repeated timer.
+        auto usec = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - timer.expire_time_)
+                        .count();
+        std::lock_guard<std::mutex> lk(mtx);
+        if (static_cast<int>(lateness.size()) < ticks) {
+            lateness.push_back(usec);
+            if (static_cast<int>(lateness.size()) == ticks)
+                cv.notify_one();
+        }
+    });
+
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        cv.wait_for(lk,
+                    std::chrono::microseconds(static_cast<long long>(ticks) *
+                                              interval * 2 + 1000000),
+                    [&] { return static_cast<int>(lateness.size()) == ticks; });
+    }
+    timer.cancel();
+    myasio->stop_service();
+
+    std::lock_guard<std::mutex> lk(mtx);
+    if (lateness.empty()) {
+        printf("no ticks!\n");
+        return 1;
+    }
+    std::sort(lateness.begin(), lateness.end());
+
+    static const long long bounds[] = {50, 100, 250, 500, 1000};
+    int histogram[_ARRAYSIZE(bounds) + 1] = {0};
+    int early = 0;
+    for (auto usec : lateness) {
+        if (usec < 0)
+            ++early;
+        size_t i = 0;
+        while (i < _ARRAYSIZE(bounds) && usec >= bounds[i])
+            ++i;
+        ++histogram[i];
+    }
+
+    const size_t n = lateness.size();
+    printf("%s%s, %zu ticks of %dus: early=%d p50=%lldus p99=%lldus "
+           "max=%lldus\n",
+#if _USE_TIMERFD
+           "timerfd + ",
+#else
+           "wait timeout + ",
+#endif
+#if _USE_EPOLL_REACTOR
+           "epoll",
+#else
+           "select",
+#endif
+           n, interval, early, lateness[n / 2], lateness[n * 99 / 100],
+           lateness.back());
+    for (size_t i = 0; i < _ARRAYSIZE(bounds); ++i)
+        printf("  < %4lldus: %d\n", bounds[i], histogram[i]);
+    printf("  >=%4lldus: %d\n", bounds[_ARRAYSIZE(bounds) - 1],
+           histogram[_ARRAYSIZE(bounds)]);
+    return 0;
+}
@@ -0,0 +1,89 @@
+// The schedule & cancel cost of the 4-ary heap deadline_timer_queue vs the
+// legacy sorted timer vector(std::find + std::sort on every schedule).
+//
+// build: g++ -std=c++11 -O2 -I../../src timer_queue_bench.cpp
+//   ../../src/async_socket_io.cpp ../../src/xxsocket.cpp
+//   ../../src/deadline_timer.cpp -lcares -lpthread -o timer_queue_bench
+// usage: timer_queue_bench [ops=100]
+#include "async_socket_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <random>
+
+using namespace purelib::inet;
+
+// The timer queue before the heap, the earliest timer is at the back.
+struct legacy_timer_queue {
+    void push(deadline_timer *timer) {
+        if (std::find(queue_.begin(), queue_.end(), timer) != queue_.end())
+            return;
+        queue_.push_back(timer);
+        sort();
+    }
+    void erase(deadline_timer *timer) {
+        auto iter = std::find(queue_.begin(), queue_.end(), timer);
+        if (iter != queue_.end())
+            queue_.erase(iter);
+    }
+    void sort() {
+        std::sort(queue_.begin(), queue_.end(),
+                  [](deadline_timer *lhs, deadline_timer *rhs) {
+                      return lhs->wait_duration() > rhs->wait_duration();
+                  });
+    }
+    std::vector<deadline_timer *> queue_;
+};
+
+template <typename _Fn> static double measure_ns(int ops, _Fn fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ops; ++i)
+        fn(i);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+               .count() /
+           static_cast<double>(ops);
+}
+
+int main(int argc, char **argv) {
+    const int ops = argc > 1 ? atoi(argv[1]) : 100;
+    const int sizes[] = {100, 1000, 10000, 50000};
+
+    async_socket_io service; // not started, only the timers owner
+    std::mt19937 rng(2018);
+    std::uniform_int_distribution<int> random_msec(1, 60000);
+
+    printf("%8s %16s %16s %16s %16s\n", "timers", "vector schedule",
+           "vector cancel", "heap schedule", "heap cancel");
+    for (int size : sizes) {
+        std::vector<std::unique_ptr<deadline_timer>> timers;
+        for (int i = 0; i < size + ops; ++i) {
+            timers.emplace_back(new deadline_timer(service));
+            timers.back()->expires_from_now(
+                std::chrono::milliseconds(random_msec(rng)));
+        }
+
+        // The queues hold size timers, the ops timers are scheduled and
+        // cancelled on them.
+        legacy_timer_queue legacy;
+        deadline_timer_queue heap;
+        for (int i = 0; i < size; ++i) {
+            legacy.queue_.push_back(timers[i].get());
+            heap.push(timers[i].get());
+        }
+        legacy.sort();
+
+        double vector_schedule = measure_ns(
+            ops, [&](int i) { legacy.push(timers[size + i].get()); });
+        double vector_cancel = measure_ns(
+            ops, [&](int i) { legacy.erase(timers[size + i].get()); });
+        double heap_schedule = measure_ns(
+            ops, [&](int i) { heap.push(timers[size + i].get()); });
+        double heap_cancel = measure_ns(
+            ops, [&](int i) { heap.erase(timers[size + i].get()); });
+
+        printf("%8d %13.0f ns %13.0f ns %13.0f ns %13.0f ns\n", size,
+               vector_schedule, vector_cancel, heap_schedule, heap_cancel);
+    }
+    return 0;
+}
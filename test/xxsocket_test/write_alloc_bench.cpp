@@ -0,0 +1,123 @@
+// The heap allocations of write() at a producer thread in steady state, the
+// pdu payloads are prepared before counting, so only the cost of write()
+// itself is counted: the a_pdu, it's owner and the submission.
+//
+// build: g++ -std=c++11 -O2 -I../../src write_alloc_bench.cpp
+//   ../../src/async_socket_io.cpp ../../src/xxsocket.cpp
+//   ../../src/deadline_timer.cpp -lcares -lpthread -o write_alloc_bench
+// usage: write_alloc_bench [writes=100000]
+#include "async_socket_io.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+using namespace purelib::inet;
+
+// The allocations of current thread
+static thread_local long long s_allocations = 0;
+
+void *operator new(size_t size) {
+    ++s_allocations;
+    void *p = malloc(size != 0 ? size : 1);
+    if (p == nullptr)
+        throw std::bad_alloc();
+    return p;
+}
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static bool decode_pdu_length(char *data, size_t datalen, int &len) {
+    len = datalen >= 1 ? static_cast<unsigned char>(data[0]) : -1;
+    return true;
+}
+
+template <typename _Pdu> static std::vector<_Pdu> make_pdus(int count) {
+    const char bytes[64] = {64};
+    std::vector<_Pdu> pdus;
+    pdus.reserve(count);
+    for (int i = 0; i < count; ++i)
+        pdus.push_back(_Pdu(bytes, bytes + sizeof(bytes)));
+    return pdus;
+}
+
+// Write the pdus by rounds, wait them received after each round, so the
+// pools are recycled as the steady state. Returns the allocations counted.
+template <typename _Pdu>
+static long long write_pdus(std::shared_ptr<channel_transport> transport,
+                            int count, std::atomic<int> &received) {
+    const int round = 1000;
+    long long allocations = 0;
+    for (int i = 0; i < count; i += round) {
+        auto pdus = make_pdus<_Pdu>(round);
+        int expected = received + round;
+        long long start = s_allocations;
+        for (auto &pdu : pdus)
+            myasio->write(transport, std::move(pdu));
+        allocations += s_allocations - start;
+        while (received < expected) {
+            myasio->dispatch_received_pdu(1000000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+    return allocations;
+}
+
+int main(int argc, char **argv) {
+    int writes = argc > 1 ? atoi(argv[1]) : 100000;
+
+    std::atomic<int> received(0);
+    std::shared_ptr<channel_transport> client;
+    std::mutex mtx;
+    std::condition_variable cv;
+
+    channel_endpoint eps[] = {
+        {"127.0.0.1", 36994}, // client
+        {"0.0.0.0", 36994},   // server
+    };
+    myasio->set_callbacks(
+        decode_pdu_length,
+        [&](size_t index, std::shared_ptr<channel_transport> transport,
+            int ec) {
+            if (index == 0 && ec == 0) {
+                std::lock_guard<std::mutex> lk(mtx);
+                client = transport;
+                cv.notify_one();
+            }
+        },
+        [](std::shared_ptr<channel_transport>) {},
+        [&](recv_pdu_type &&) { ++received; },
+        [](const vdcallback_t &callback) { callback(); });
+    myasio->start_service(eps, _ARRAYSIZE(eps));
+    myasio->open(1, CHANNEL_TCP_SERVER);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    myasio->open(0, CHANNEL_TCP_CLIENT);
+    {
+        std::unique_lock<std::mutex> lk(mtx);
+        if (!cv.wait_for(lk, std::chrono::seconds(5),
+                         [&] { return client != nullptr; })) {
+            printf("connect failed!\n");
+            return 1;
+        }
+    }
+
+    // warm up the thread caches of pools
+    write_pdus<std::vector<char>>(client, 10000, received);
+    write_pdus<pdu_buffer>(client, 10000, received);
+
+    long long vector_allocations =
+        write_pdus<std::vector<char>>(client, writes, received);
+    long long buffer_allocations =
+        write_pdus<pdu_buffer>(client, writes, received);
+
+    printf("%d writes, heap allocations per write: std::vector<char> %.3f, "
+           "pdu_buffer %.3f\n",
+           writes, static_cast<double>(vector_allocations) / writes,
+           static_cast<double>(buffer_allocations) / writes);
+
+    myasio->close(client);
+    myasio->close(1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    myasio->stop_service();
+    return 0;
+}